@@ -39,6 +39,8 @@
 #include "emufile.h"
 #include "utils/task.h"
 
+#include <rthreads/rthreads.h>
+
 
 #ifdef FASTBUILD
 	#undef FORCEINLINE
@@ -3885,6 +3887,7 @@ void GPUEngineA::_RenderLine_DisplayCapture(const GPUEngineCompositorInfo &compI
 	const void *srcAPtr;
 	const void *srcBPtr;
 	u16 *dstNative16 = this->_VRAMNativeBlockPtr[DISPCAPCNT.VRAMWriteBlock] + dstNativeOffset;
+	MMU_VRAMMarkDirtyRange((u32)((u8 *)dstNative16 - MMU.ARM9_LCD), CAPTURELENGTH * sizeof(u16));
 	
 	if (!willWriteVRAMLineNative)
 	{
@@ -4623,6 +4626,26 @@ GPUSubsystem::GPUSubsystem()
 	
 	_asyncEngineBufferSetupIsRunning = false;
 	
+	// These threads are only started once SetWillDeferLineRender() or
+	// SetWillRenderEnginesInParallel() asks for them.
+	_deferredLineRenderTask = NULL;
+	_deferredLineRenderLock = NULL;
+	_deferredLineRenderCondition = NULL;
+	_engineSubRenderTask = NULL;
+	
+	memset(_deferredLineRecord, 0, sizeof(_deferredLineRecord));
+	_deferredLineNext[GPUEngineID_Main] = 0;
+	_deferredLineNext[GPUEngineID_Sub] = 0;
+	_deferredLineEnd = 0;
+	_deferredLineRenderNeedsStop = false;
+	_deferredLineRenderIsRunning = false;
+	_deferredLineRenderIsSplit = false;
+	_willDeferLineRender = false;
+	
+	_engineSubRenderLine = 0;
+	_engineSubRenderLineWillRender = false;
+	_willRenderEnginesInParallel = false;
+	
 	_pending3DRendererID = RENDERID_NULL;
 	_needChange3DRenderer = false;
 	
@@ -4724,6 +4747,24 @@ GPUSubsystem::~GPUSubsystem()
 		this->_asyncEngineBufferSetupTask = NULL;
 	}
 	
+	if (this->_deferredLineRenderTask != NULL)
+	{
+		this->_StopDeferredLineRender();
+		delete this->_deferredLineRenderTask;
+		this->_deferredLineRenderTask = NULL;
+		
+		scond_free(this->_deferredLineRenderCondition);
+		this->_deferredLineRenderCondition = NULL;
+		slock_free(this->_deferredLineRenderLock);
+		this->_deferredLineRenderLock = NULL;
+	}
+	
+	if (this->_engineSubRenderTask != NULL)
+	{
+		delete this->_engineSubRenderTask;
+		this->_engineSubRenderTask = NULL;
+	}
+	
 	free_aligned(this->_masterFramebuffer);
 	free_aligned(this->_masterWorkingNativeBuffer32);
 	free_aligned(this->_customVRAM);
@@ -4773,6 +4814,7 @@ GPUEventHandler* GPUSubsystem::GetEventHandler()
 
 void GPUSubsystem::Reset()
 {
+	this->_StopDeferredLineRender();
 	this->_engineMain->RenderLineClearAsyncFinish();
 	this->_engineSub->RenderLineClearAsyncFinish();
 	this->AsyncSetupEngineBuffersFinish();
@@ -4830,12 +4872,17 @@ void GPUSubsystem::Reset()
 
 void GPUSubsystem::ForceRender3DFinishAndFlush(bool willFlush)
 {
+	// Lines still being rendered might be reading the 3D framebuffer.
+	this->FinishDeferredLineRender();
+	
 	CurrentRenderer->RenderFinish();
 	CurrentRenderer->RenderFlush(willFlush, willFlush);
 }
 
 void GPUSubsystem::ForceFrameStop()
 {
+	this->_StopDeferredLineRender();
+	
 	if (CurrentRenderer->GetRenderNeedsFinish())
 	{
 		this->ForceRender3DFinishAndFlush(true);
@@ -4965,6 +5012,8 @@ size_t GPUSubsystem::GetFramebufferPageCount() const
 
 void GPUSubsystem::SetFramebufferPageCount(size_t pageCount)
 {
+	this->_StopDeferredLineRender();
+	
 	if (pageCount > MAX_FRAMEBUFFER_PAGES)
 	{
 		pageCount = MAX_FRAMEBUFFER_PAGES;
@@ -4990,6 +5039,8 @@ void GPUSubsystem::SetCustomFramebufferSize(size_t w, size_t h)
 		return;
 	}
 	
+	this->_StopDeferredLineRender();
+	
 	this->_engineMain->RenderLineClearAsyncFinish();
 	this->_engineSub->RenderLineClearAsyncFinish();
 	this->AsyncSetupEngineBuffersFinish();
@@ -5126,6 +5177,8 @@ void GPUSubsystem::SetColorFormat(const NDSColorFormat outputFormat)
 		return;
 	}
 	
+	this->_StopDeferredLineRender();
+	
 	this->_engineMain->RenderLineClearAsyncFinish();
 	this->_engineSub->RenderLineClearAsyncFinish();
 	this->AsyncSetupEngineBuffersFinish();
@@ -5438,6 +5491,17 @@ void GPUSubsystem::RenderLine(const size_t l)
 		this->_event->DidApplyGPUSettingsBegin();
 		this->_engineMain->ApplySettings();
 		this->_engineSub->ApplySettings();
+		
+		if (this->_willDeferLineRender != CommonSettings.GPU_DeferLineRender)
+		{
+			this->SetWillDeferLineRender(CommonSettings.GPU_DeferLineRender);
+		}
+		
+		if (this->_willRenderEnginesInParallel != CommonSettings.GPU_RenderEnginesInParallel)
+		{
+			this->SetWillRenderEnginesInParallel(CommonSettings.GPU_RenderEnginesInParallel);
+		}
+		
 		this->_event->DidApplyGPUSettingsEnd();
 		
 		this->_display[NDSDisplayID_Main]->SetIsEnabled( this->_display[NDSDisplayID_Main]->GetEngine()->GetEnableStateApplied() );
@@ -5474,13 +5538,10 @@ void GPUSubsystem::RenderLine(const size_t l)
 		}
 	}
 	
-	if (!this->_willFrameSkip)
-	{
-		this->_engineMain->UpdateRenderStates(l);
-		this->_engineSub->UpdateRenderStates(l);
-	}
+	const bool willRenderMain = (isFramebufferRenderNeeded[GPUEngineID_Main] || this->_engineMain->IsForceBlankSet() || isDisplayCaptureNeeded) && !this->_willFrameSkip;
+	const bool willRenderSub  = (isFramebufferRenderNeeded[GPUEngineID_Sub]  || this->_engineSub->IsForceBlankSet()) && !this->_willFrameSkip;
 	
-	if ( (isFramebufferRenderNeeded[GPUEngineID_Main] || this->_engineMain->IsForceBlankSet() || isDisplayCaptureNeeded) && !this->_willFrameSkip )
+	if (willRenderMain)
 	{
 		// GPUEngineA:WillRender3DLayer() and GPUEngineA:WillCapture3DLayerDirect() both rely on register
 		// states that might change on a per-line basis. Therefore, we need to check these states on a
@@ -5507,51 +5568,26 @@ void GPUSubsystem::RenderLine(const size_t l)
 			CurrentRenderer->RenderFlush(need3DDisplayFramebuffer && CurrentRenderer->GetRenderNeedsFlushMain(),
 			                             need3DCaptureFramebuffer && CurrentRenderer->GetRenderNeedsFlush16());
 		}
-		
-		switch (this->_engineMain->GetTargetDisplay()->GetColorFormat())
-		{
-			case NDSColorFormat_BGR555_Rev:
-				this->_engineMain->RenderLine<NDSColorFormat_BGR555_Rev>(l);
-				break;
-				
-			case NDSColorFormat_BGR666_Rev:
-				this->_engineMain->RenderLine<NDSColorFormat_BGR666_Rev>(l);
-				break;
-				
-			case NDSColorFormat_BGR888_Rev:
-				this->_engineMain->RenderLine<NDSColorFormat_BGR888_Rev>(l);
-				break;
-		}
-	}
-	else
-	{
-		this->_engineMain->UpdatePropertiesWithoutRender(l);
 	}
 	
-	if ( (isFramebufferRenderNeeded[GPUEngineID_Sub] || this->_engineSub->IsForceBlankSet()) && !this->_willFrameSkip)
+	// A display capture writes into VRAM, which the emulation may read back at any time,
+	// so always render those lines right here.
+	if ( this->_willDeferLineRender && (this->_deferredLineRenderTask != NULL) && !this->_willFrameSkip && !isDisplayCaptureNeeded )
 	{
-		switch (this->_engineSub->GetTargetDisplay()->GetColorFormat())
-		{
-			case NDSColorFormat_BGR555_Rev:
-				this->_engineSub->RenderLine<NDSColorFormat_BGR555_Rev>(l);
-				break;
-				
-			case NDSColorFormat_BGR666_Rev:
-				this->_engineSub->RenderLine<NDSColorFormat_BGR666_Rev>(l);
-				break;
-				
-			case NDSColorFormat_BGR888_Rev:
-				this->_engineSub->RenderLine<NDSColorFormat_BGR888_Rev>(l);
-				break;
-		}
+		this->_DeferLineRender(l, willRenderMain, willRenderSub);
 	}
 	else
 	{
-		this->_engineSub->UpdatePropertiesWithoutRender(l);
+		// Stop the deferred render threads rather than just waiting on them, since the sub
+		// engine's render thread may be needed for this line.
+		this->_StopDeferredLineRender();
+		this->_RenderLineEngines(l, willRenderMain, willRenderSub);
 	}
 	
 	if (l == 191)
 	{
+		this->_StopDeferredLineRender();
+		
 		this->_engineMain->LastLineProcess();
 		this->_engineSub->LastLineProcess();
 		
@@ -5613,6 +5649,282 @@ void GPUSubsystem::RenderLine(const size_t l)
 	}
 }
 
+void GPUSubsystem::_RenderLineEngineMain(const size_t l, const bool willRender)
+{
+	if (!this->_willFrameSkip)
+	{
+		this->_engineMain->UpdateRenderStates(l);
+	}
+	
+	if (willRender)
+	{
+		switch (this->_engineMain->GetTargetDisplay()->GetColorFormat())
+		{
+			case NDSColorFormat_BGR555_Rev:
+				this->_engineMain->RenderLine<NDSColorFormat_BGR555_Rev>(l);
+				break;
+				
+			case NDSColorFormat_BGR666_Rev:
+				this->_engineMain->RenderLine<NDSColorFormat_BGR666_Rev>(l);
+				break;
+				
+			case NDSColorFormat_BGR888_Rev:
+				this->_engineMain->RenderLine<NDSColorFormat_BGR888_Rev>(l);
+				break;
+		}
+	}
+	else
+	{
+		this->_engineMain->UpdatePropertiesWithoutRender(l);
+	}
+}
+
+void GPUSubsystem::_RenderLineEngineSub(const size_t l, const bool willRender)
+{
+	if (!this->_willFrameSkip)
+	{
+		this->_engineSub->UpdateRenderStates(l);
+	}
+	
+	if (willRender)
+	{
+		switch (this->_engineSub->GetTargetDisplay()->GetColorFormat())
+		{
+			case NDSColorFormat_BGR555_Rev:
+				this->_engineSub->RenderLine<NDSColorFormat_BGR555_Rev>(l);
+				break;
+				
+			case NDSColorFormat_BGR666_Rev:
+				this->_engineSub->RenderLine<NDSColorFormat_BGR666_Rev>(l);
+				break;
+				
+			case NDSColorFormat_BGR888_Rev:
+				this->_engineSub->RenderLine<NDSColorFormat_BGR888_Rev>(l);
+				break;
+		}
+	}
+	else
+	{
+		this->_engineSub->UpdatePropertiesWithoutRender(l);
+	}
+}
+
+static void* GPUSubsystem_RunEngineSubRenderLine(void *arg)
+{
+	GPUSubsystem *gpuSubystem = (GPUSubsystem *)arg;
+	gpuSubystem->RunEngineSubRenderLine();
+	
+	return NULL;
+}
+
+void GPUSubsystem::RunEngineSubRenderLine()
+{
+	this->_RenderLineEngineSub(this->_engineSubRenderLine, this->_engineSubRenderLineWillRender);
+}
+
+void GPUSubsystem::_RenderLineEngines(const size_t l, const bool willRenderMain, const bool willRenderSub)
+{
+	if (this->_willRenderEnginesInParallel && (this->_engineSubRenderTask != NULL) && !this->_willFrameSkip)
+	{
+		this->_engineSubRenderLine = l;
+		this->_engineSubRenderLineWillRender = willRenderSub;
+		this->_engineSubRenderTask->execute(&GPUSubsystem_RunEngineSubRenderLine, this);
+		
+		this->_RenderLineEngineMain(l, willRenderMain);
+		
+		this->_engineSubRenderTask->finish();
+	}
+	else
+	{
+		this->_RenderLineEngineMain(l, willRenderMain);
+		this->_RenderLineEngineSub(l, willRenderSub);
+	}
+}
+
+static void* GPUSubsystem_RunDeferredLineRenderMain(void *arg)
+{
+	GPUSubsystem *gpuSubystem = (GPUSubsystem *)arg;
+	gpuSubystem->RunDeferredLineRender(GPUEngineID_Main);
+	
+	return NULL;
+}
+
+static void* GPUSubsystem_RunDeferredLineRenderSub(void *arg)
+{
+	GPUSubsystem *gpuSubystem = (GPUSubsystem *)arg;
+	gpuSubystem->RunDeferredLineRender(GPUEngineID_Sub);
+	
+	return NULL;
+}
+
+void GPUSubsystem::RunDeferredLineRender(const GPUEngineID engineID)
+{
+	// If the engines aren't split between two threads, then the main engine's thread
+	// renders both engines, and keeps both line counters together.
+	const bool willRenderBothEngines = (engineID == GPUEngineID_Main) && !this->_deferredLineRenderIsSplit;
+	size_t &nextLine = this->_deferredLineNext[engineID];
+	
+	slock_lock(this->_deferredLineRenderLock);
+	
+	while (true)
+	{
+		while ( (nextLine == this->_deferredLineEnd) && !this->_deferredLineRenderNeedsStop )
+		{
+			scond_wait(this->_deferredLineRenderCondition, this->_deferredLineRenderLock);
+		}
+		
+		// When stopping, finish off any lines that are still queued before leaving.
+		if (nextLine == this->_deferredLineEnd)
+		{
+			break;
+		}
+		
+		const size_t l = nextLine;
+		const GPUDeferredLineRecord lineRecord = this->_deferredLineRecord[l];
+		slock_unlock(this->_deferredLineRenderLock);
+		
+		if (engineID == GPUEngineID_Main)
+		{
+			this->_RenderLineEngineMain(l, lineRecord.willRenderMain);
+			
+			if (willRenderBothEngines)
+			{
+				this->_RenderLineEngineSub(l, lineRecord.willRenderSub);
+			}
+		}
+		else
+		{
+			this->_RenderLineEngineSub(l, lineRecord.willRenderSub);
+		}
+		
+		slock_lock(this->_deferredLineRenderLock);
+		nextLine++;
+		
+		if (willRenderBothEngines)
+		{
+			this->_deferredLineNext[GPUEngineID_Sub] = nextLine;
+		}
+		
+		if (nextLine == this->_deferredLineEnd)
+		{
+			scond_broadcast(this->_deferredLineRenderCondition);
+		}
+	}
+	
+	slock_unlock(this->_deferredLineRenderLock);
+}
+
+void GPUSubsystem::_DeferLineRender(const size_t l, const bool willRenderMain, const bool willRenderSub)
+{
+	const bool needsStart = !this->_deferredLineRenderIsRunning;
+	
+	slock_lock(this->_deferredLineRenderLock);
+	
+	if (needsStart)
+	{
+		this->_deferredLineNext[GPUEngineID_Main] = l;
+		this->_deferredLineNext[GPUEngineID_Sub] = l;
+		this->_deferredLineEnd = l;
+		this->_deferredLineRenderNeedsStop = false;
+		this->_deferredLineRenderIsSplit = this->_willRenderEnginesInParallel && (this->_engineSubRenderTask != NULL);
+	}
+	
+	this->_deferredLineRecord[l].willRenderMain = willRenderMain;
+	this->_deferredLineRecord[l].willRenderSub = willRenderSub;
+	this->_deferredLineEnd = l + 1;
+	
+	scond_broadcast(this->_deferredLineRenderCondition);
+	slock_unlock(this->_deferredLineRenderLock);
+	
+	if (needsStart)
+	{
+		this->_deferredLineRenderTask->execute(&GPUSubsystem_RunDeferredLineRenderMain, this);
+		
+		if (this->_deferredLineRenderIsSplit)
+		{
+			this->_engineSubRenderTask->execute(&GPUSubsystem_RunDeferredLineRenderSub, this);
+		}
+		
+		this->_deferredLineRenderIsRunning = true;
+	}
+}
+
+void GPUSubsystem::_WaitDeferredLineRender()
+{
+	slock_lock(this->_deferredLineRenderLock);
+	
+	while ( (this->_deferredLineNext[GPUEngineID_Main] != this->_deferredLineEnd) ||
+	        (this->_deferredLineNext[GPUEngineID_Sub]  != this->_deferredLineEnd) )
+	{
+		scond_wait(this->_deferredLineRenderCondition, this->_deferredLineRenderLock);
+	}
+	
+	slock_unlock(this->_deferredLineRenderLock);
+}
+
+void GPUSubsystem::_StopDeferredLineRender()
+{
+	if (!this->_deferredLineRenderIsRunning)
+	{
+		return;
+	}
+	
+	slock_lock(this->_deferredLineRenderLock);
+	this->_deferredLineRenderNeedsStop = true;
+	scond_broadcast(this->_deferredLineRenderCondition);
+	slock_unlock(this->_deferredLineRenderLock);
+	
+	this->_deferredLineRenderTask->finish();
+	
+	if (this->_deferredLineRenderIsSplit)
+	{
+		this->_engineSubRenderTask->finish();
+	}
+	
+	this->_deferredLineRenderIsRunning = false;
+}
+
+bool GPUSubsystem::GetWillDeferLineRender() const
+{
+	return this->_willDeferLineRender;
+}
+
+void GPUSubsystem::SetWillDeferLineRender(const bool willDefer)
+{
+	if (!willDefer)
+	{
+		this->_StopDeferredLineRender();
+	}
+	else if ( (this->_deferredLineRenderTask == NULL) && (CommonSettings.num_cores > 1) )
+	{
+		this->_deferredLineRenderLock = slock_new();
+		this->_deferredLineRenderCondition = scond_new();
+		this->_deferredLineRenderTask = new Task;
+		this->_deferredLineRenderTask->start(false, 0, "gpu 2d render");
+	}
+	
+	this->_willDeferLineRender = willDefer;
+}
+
+bool GPUSubsystem::GetWillRenderEnginesInParallel() const
+{
+	return this->_willRenderEnginesInParallel;
+}
+
+void GPUSubsystem::SetWillRenderEnginesInParallel(const bool willRenderInParallel)
+{
+	// The deferred line render threads decide how to split up the engines when they start.
+	this->_StopDeferredLineRender();
+	
+	if ( willRenderInParallel && (this->_engineSubRenderTask == NULL) && (CommonSettings.num_cores > 1) )
+	{
+		this->_engineSubRenderTask = new Task;
+		this->_engineSubRenderTask->start(false, 0, "gpu 2d render sub");
+	}
+	
+	this->_willRenderEnginesInParallel = willRenderInParallel;
+}
+
 void GPUSubsystem::UpdateAverageBacklightIntensityTotal()
 {
 	// The values in this table are, more or less, arbitrarily chosen.
@@ -5641,6 +5953,8 @@ void GPUSubsystem::UpdateAverageBacklightIntensityTotal()
 
 void GPUSubsystem::ClearWithColor(const u16 colorBGRA5551)
 {
+	this->_StopDeferredLineRender();
+	
 	const u16 color16 = colorBGRA5551 | 0x8000;
 	const size_t nativeFramebufferPixCount = GPU_FRAMEBUFFER_NATIVE_WIDTH * GPU_FRAMEBUFFER_NATIVE_HEIGHT * 2;
 	const size_t customFramebufferPixCount = this->_displayInfo.customWidth * this->_displayInfo.customHeight * 2;
@@ -5798,6 +6112,8 @@ void GPUSubsystem::_ConvertAndUpscaleForLoadstate(const NDSDisplayID displayID,
 
 void GPUSubsystem::SaveState(EMUFILE &os)
 {
+	this->FinishDeferredLineRender();
+	
 	// Savestate chunk version
 	os.write_32LE(2);
 	
@@ -5827,6 +6143,8 @@ void GPUSubsystem::SaveState(EMUFILE &os)
 
 bool GPUSubsystem::LoadState(EMUFILE &is, int size)
 {
+	this->_StopDeferredLineRender();
+	
 	u32 version;
 	
 	//sigh.. shouldve used a new version number
@@ -58,6 +58,8 @@ class EMUFILE;
 class Task;
 struct MMU_struct;
 struct Render3DInterface;
+typedef struct slock slock_t;
+typedef struct scond scond_t;
 
 //#undef FORCEINLINE
 //#define FORCEINLINE
@@ -1869,6 +1871,14 @@ public:
 	virtual void DidApplyRender3DSettingsEnd() {};
 };
 
+// What the emulation thread decided for a line that was handed off to the deferred
+// line render thread.
+typedef struct
+{
+	bool willRenderMain;
+	bool willRenderSub;
+} GPUDeferredLineRecord;
+
 class GPUSubsystem
 {
 private:
@@ -1883,6 +1893,22 @@ private:
 	Task *_asyncEngineBufferSetupTask;
 	bool _asyncEngineBufferSetupIsRunning;
 	
+	Task *_deferredLineRenderTask;
+	slock_t *_deferredLineRenderLock;
+	scond_t *_deferredLineRenderCondition;
+	GPUDeferredLineRecord _deferredLineRecord[GPU_FRAMEBUFFER_NATIVE_HEIGHT];
+	size_t _deferredLineNext[2];	// The next line that each engine's render thread will render, indexed by GPUEngineID. Guarded by _deferredLineRenderLock.
+	size_t _deferredLineEnd;		// One past the last line handed to the render threads. Guarded by _deferredLineRenderLock.
+	bool _deferredLineRenderNeedsStop;
+	bool _deferredLineRenderIsRunning;
+	bool _deferredLineRenderIsSplit;
+	bool _willDeferLineRender;
+	
+	Task *_engineSubRenderTask;
+	size_t _engineSubRenderLine;
+	bool _engineSubRenderLineWillRender;
+	bool _willRenderEnginesInParallel;
+	
 	int _pending3DRendererID;
 	bool _needChange3DRenderer;
 	
@@ -1906,6 +1932,13 @@ private:
 	void _DownscaleAndConvertForSavestate(const NDSDisplayID displayID, const void *srcBuffer, u16 *dstBuffer);
 	void _ConvertAndUpscaleForLoadstate(const NDSDisplayID displayID, const u16 *srcBuffer, void *dstBuffer);
 	
+	void _RenderLineEngineMain(const size_t l, const bool willRender);
+	void _RenderLineEngineSub(const size_t l, const bool willRender);
+	void _RenderLineEngines(const size_t l, const bool willRenderMain, const bool willRenderSub);
+	void _DeferLineRender(const size_t l, const bool willRenderMain, const bool willRenderSub);
+	void _WaitDeferredLineRender();
+	void _StopDeferredLineRender();
+	
 public:
 	GPUSubsystem();
 	~GPUSubsystem();
@@ -1988,6 +2021,38 @@ public:
 	void AsyncSetupEngineBuffersStart();
 	void AsyncSetupEngineBuffersFinish();
 	
+	// Normally, each line is rendered by both 2D engines on the emulation thread at H-blank.
+	// If SetWillDeferLineRender() is passed "true", then the line's render work is handed
+	// off to a separate thread instead, and the emulation moves on immediately. The render
+	// thread catches up whenever the emulation is about to change something that the 2D
+	// engines read (the GPU I/O registers, VRAMCNT, POWCNT1, palette, VRAM or OAM), and
+	// always by the end of line 191. Lines with a display capture are rendered on the
+	// emulation thread as usual, since the capture writes back into VRAM.
+	//
+	// The render thread is started the first time this is enabled. This has no effect if
+	// the system has only a single CPU core. RenderLine() applies
+	// CommonSettings.GPU_DeferLineRender at the start of every frame.
+	bool GetWillDeferLineRender() const;
+	void SetWillDeferLineRender(const bool willDefer);
+	bool IsDeferredLineRenderRunning() const;
+	void FinishDeferredLineRender();
+	void RunDeferredLineRender(const GPUEngineID engineID);
+	
+	// Normally, the main and sub engines render each line one after the other. If
+	// SetWillRenderEnginesInParallel() is passed "true", then the sub engine renders on its
+	// own thread at the same time as the main engine. The two engines share no output
+	// buffers, and while a display capture writes into VRAM, it only ever writes into a bank
+	// mapped to LCDC, which the sub engine cannot read from. Each line waits for both engines
+	// to finish, unless the line render is also deferred, in which case the two engines
+	// each work through the deferred lines at their own pace.
+	//
+	// The sub engine's thread is started the first time this is enabled. This has no effect
+	// if the system has only a single CPU core. RenderLine() applies
+	// CommonSettings.GPU_RenderEnginesInParallel at the start of every frame.
+	bool GetWillRenderEnginesInParallel() const;
+	void SetWillRenderEnginesInParallel(const bool willRenderInParallel);
+	void RunEngineSubRenderLine();
+	
 	void RenderLine(const size_t l);
 	void UpdateAverageBacklightIntensityTotal();
 	void ClearWithColor(const u16 colorBGRA5551);
@@ -2035,4 +2100,18 @@ public:
 extern GPUSubsystem *GPU;
 extern MMU_struct MMU;
 
+// These are called on every memory write that might affect the 2D engines, so keep them inline.
+FORCEINLINE bool GPUSubsystem::IsDeferredLineRenderRunning() const
+{
+	return this->_deferredLineRenderIsRunning;
+}
+
+FORCEINLINE void GPUSubsystem::FinishDeferredLineRender()
+{
+	if (this->_deferredLineRenderIsRunning)
+	{
+		this->_WaitDeferredLineRender();
+	}
+}
+
 #endif
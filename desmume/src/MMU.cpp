@@ -286,6 +286,14 @@ u8 vram_arm9_map[VRAM_ARM9_PAGES];
 //this chooses which banks are mapped in the 128K banks starting at 0x06000000 in ARM7
 u8 vram_arm7_map[2];
 
+//one bit per 4KB page of the LCDC buffer, set whenever the page is written
+u32 vram_dirty_map[VRAM_DIRTY_MAP_SIZE];
+
+//the same for main RAM and the LCDC buffer, but owned by the snapshot code
+u32 mmu_snapshot_main_dirty[MMU_SNAPSHOT_MAIN_PAGES / 32];
+u32 mmu_snapshot_vram_dirty[VRAM_DIRTY_MAP_SIZE];
+u32 mmu_main_write_gen[MMU_SNAPSHOT_MAIN_PAGES];
+
 //----->
 //consider these later, for better recordkeeping, instead of using the u8* in MMU
 
@@ -457,6 +465,211 @@ static FORCEINLINE u32 MMU_LCDmap(u32 addr, bool& unmapped, bool& restricted)
 		return LCDC_HACKY_LOCATION + (vram_page<<14) + ofs;
 }
 
+//VRAM addresses returned by MMU_LCDmap() are offsets from LCDC_HACKY_LOCATION into ARM9_LCD.
+//anything else wraps around to a huge offset and is ignored.
+static FORCEINLINE void MMU_VRAMMarkDirtyMapped(const u32 mappedAddr)
+{
+	MMU_VRAMMarkDirty(mappedAddr - LCDC_HACKY_LOCATION);
+}
+
+//main RAM normally takes the inline path in _MMU_write*(), but the generic handlers
+//still get called for it directly (by the JIT's LDM/STM fallback, for one)
+static FORCEINLINE void MMU_MainMemMarkDirtyMapped(const u32 adr)
+{
+	if ((adr >> 24) == 0x02)
+		MMU_MainMemMarkDirty(adr & _MMU_MAIN_MEM_MASK);
+}
+
+u8 *mmu_tlb_read[2][MMU_TLB_PAGES];
+u8 *mmu_tlb_write[2][MMU_TLB_PAGES];
+#ifdef HAVE_JIT
+uintptr_t *mmu_tlb_jit[2][MMU_TLB_PAGES];
+//compiled code isn't tracked for DTCM, so its writes clear slots that nobody looks at
+static uintptr_t mmu_tlb_jit_scratch[(MMU_TLB_PAGE_MASK + 1) >> 1];
+#endif
+static bool mmu_tlb_hooked = false;
+
+//whether anything needs to see every data access: the same things the full _MMU_read/_MMU_write path checks for,
+//other than the memory hooks, which only keep the pages they cover out of the tables (see MMU_TLBPageHooked())
+static bool MMU_TLBHooked()
+{
+#ifdef GDB_STUB
+	return true;
+#else
+	if (CheckDebugEvent(DEBUG_EVENT_READ) || CheckDebugEvent(DEBUG_EVENT_WRITE))
+		return true;
+	if (!memReadBreakPoints.empty() || !memWriteBreakPoints.empty())
+		return true;
+	return false;
+#endif
+}
+
+#if defined(HAVE_LUA) || defined(TARGET_INTERFACE)
+//whether a hooked byte lies in the page at adr, going by the region's bits for each 4KB page
+static bool MMU_TLBRegionHooked(const TieredRegion &region, const u32 adr)
+{
+	if (region.pages.empty())
+		return false;
+
+	for (u32 ofs = 0; ofs <= MMU_TLB_PAGE_MASK; ofs += (1 << TieredRegion::PAGE_SHIFT))
+		if (region.PageHooked(adr + ofs))
+			return true;
+	return false;
+}
+#endif
+
+//whether a read or write hook covers any byte of the page at adr. both tables leave such a page
+//to the full path, since the 8-bit write path also calls the read hooks
+static bool MMU_TLBPageHooked(const u32 adr)
+{
+#ifdef HAVE_LUA
+	if (MMU_TLBRegionHooked(hookedRegions[LUAMEMHOOK_READ], adr) || MMU_TLBRegionHooked(hookedRegions[LUAMEMHOOK_WRITE], adr))
+		return true;
+#endif
+#ifdef TARGET_INTERFACE
+	if (MMU_TLBRegionHooked(hooked_regions[HOOK_READ], adr) || MMU_TLBRegionHooked(hooked_regions[HOOK_WRITE], adr))
+		return true;
+#endif
+	return false;
+}
+
+//the host memory which the full read path reaches for the page at adr, if that is plain memory laid out linearly
+template<int PROCNUM>
+static u8* MMU_TLBMapRead(u32 adr)
+{
+	const u32 bank = adr >> 24;
+
+	if (bank < 0x02)
+		return (PROCNUM == ARMCPU_ARM9) ? MMU.ARM9_ITCM + (adr & 0x7FFF) : NULL; //the arm7 bios is only readable from inside itself
+	if (bank == 0x02)
+		return MMU.MAIN_MEM + (adr & _MMU_MAIN_MEM_MASK);
+	if (bank == 0x04 || (bank >= 0x08 && bank <= 0x0A))
+		return NULL;
+	if (PROCNUM == ARMCPU_ARM9 && bank == 0x06 && adr >= 0x068A4000)
+		return NULL; //the mirrors past the LCDC buffer collapse each page onto one address
+
+	bool unmapped, restricted;
+	adr = MMU_LCDmap<PROCNUM>(adr, unmapped, restricted);
+	if (unmapped)
+		return NULL;
+
+	const u32 mask = MMU.MMU_MASK[PROCNUM][adr >> 20];
+	if ((mask & MMU_TLB_PAGE_MASK) != MMU_TLB_PAGE_MASK)
+		return NULL; //palette, OAM and the unused areas repeat every few bytes
+	return MMU.MMU_MEM[PROCNUM][adr >> 20] + (adr & mask);
+}
+
+//the same for writes, limited to the RAM MMU_TLBWrite() knows how to handle.
+//jit receives the compiled code slots the full write path would clear for the page.
+//nothing the 2D engines read may be mapped here, since these writes skip MMU_GPUDeferredLineRenderBarrier()
+template<int PROCNUM>
+static u8* MMU_TLBMapWrite(const u32 adr, uintptr_t *&jit)
+{
+	const u32 bank = adr >> 24;
+	jit = NULL;
+
+	if (PROCNUM == ARMCPU_ARM9 && bank < 0x02)
+	{
+#ifdef HAVE_JIT
+		jit = &JIT_COMPILED_FUNC_KNOWNBANK(adr, ARM9_ITCM, 0x7FFF, 0);
+#endif
+		return MMU.ARM9_ITCM + (adr & 0x7FFF);
+	}
+
+	if (bank == 0x02)
+	{
+#ifdef HAVE_JIT
+		jit = &JIT_COMPILED_FUNC_KNOWNBANK(adr, MAIN_MEM, _MMU_MAIN_MEM_MASK, 0);
+#endif
+		return MMU.MAIN_MEM + (adr & _MMU_MAIN_MEM_MASK);
+	}
+
+	if (bank == 0x03)
+	{
+		bool unmapped, restricted;
+		const u32 mapped = MMU_LCDmap<PROCNUM>(adr, unmapped, restricted);
+		if (unmapped)
+			return NULL;
+#ifdef HAVE_JIT
+		if (!JIT_MAPPED(mapped, PROCNUM))
+			return NULL;
+		jit = &JIT_COMPILED_FUNC_PREMASKED(mapped, PROCNUM, 0);
+#endif
+		return MMU.MMU_MEM[PROCNUM][mapped >> 20] + (mapped & MMU.MMU_MASK[PROCNUM][mapped >> 20]);
+	}
+
+	return NULL;
+}
+
+template<int PROCNUM>
+static void MMU_TLBRebuildPages(const u32 firstPage, const u32 endPage)
+{
+	for (u32 page = firstPage; page < endPage; page++)
+	{
+		const u32 adr = page << MMU_TLB_PAGE_SHIFT;
+		uintptr_t *jit;
+
+		if (mmu_tlb_hooked || MMU_TLBPageHooked(adr))
+		{
+			mmu_tlb_read[PROCNUM][page] = NULL;
+			mmu_tlb_write[PROCNUM][page] = NULL;
+			continue;
+		}
+
+		mmu_tlb_read[PROCNUM][page] = MMU_TLBMapRead<PROCNUM>(adr);
+		mmu_tlb_write[PROCNUM][page] = MMU_TLBMapWrite<PROCNUM>(adr, jit);
+		assert((mmu_tlb_write[PROCNUM][page] == NULL) || ((adr >> 24) < 0x04));
+#ifdef HAVE_JIT
+		mmu_tlb_jit[PROCNUM][page] = jit;
+#endif
+
+		//DTCM is patched on top of whatever else is there. DTCMRegion is only 4KB aligned (cp15 masks it with 0x0FFFF000),
+		//but the full path compares it against (adr & ~0x3FFF), so it only ever takes effect at a 16KB aligned address
+		if (PROCNUM == ARMCPU_ARM9 && adr == MMU.DTCMRegion)
+		{
+			mmu_tlb_read[PROCNUM][page] = MMU.ARM9_DTCM;
+			mmu_tlb_write[PROCNUM][page] = MMU.ARM9_DTCM;
+#ifdef HAVE_JIT
+			mmu_tlb_jit[PROCNUM][page] = mmu_tlb_jit_scratch;
+#endif
+		}
+	}
+}
+
+static void MMU_TLBRebuildRange(const u32 firstAdr, const u32 endAdr)
+{
+	MMU_TLBRebuildPages<ARMCPU_ARM9>(firstAdr >> MMU_TLB_PAGE_SHIFT, endAdr >> MMU_TLB_PAGE_SHIFT);
+	MMU_TLBRebuildPages<ARMCPU_ARM7>(firstAdr >> MMU_TLB_PAGE_SHIFT, endAdr >> MMU_TLB_PAGE_SHIFT);
+}
+
+void MMU_TLBRebuild()
+{
+	mmu_tlb_hooked = MMU_TLBHooked();
+	MMU_TLBRebuildRange(0x00000000, 0x10000000);
+}
+
+void MMU_TLBSync()
+{
+	if (MMU_TLBHooked() != mmu_tlb_hooked)
+		MMU_TLBRebuild();
+}
+
+//the 2D engines may still be rendering earlier lines on another thread (see GPUSubsystem::SetWillDeferLineRender()).
+//anything they read -- the GPU and VRAMCNT/POWCNT1 registers, palette, VRAM and OAM -- must not change under them.
+//every ARM9 write that can reach those goes through here: the full write handlers and MMU_DMABulkWrite().
+//the TLB, and the JIT's stores through it, only ever map ITCM, main RAM and shared WRAM (see MMU_TLBMapWrite()).
+static FORCEINLINE void MMU_GPUDeferredLineRenderBarrier(const u32 adr, const u32 adrBank)
+{
+	if (!GPU->IsDeferredLineRenderRunning())
+		return;
+
+	if ( ((adrBank >= 0x05) && (adrBank <= 0x07)) ||
+	     ((adrBank == 0x04) && ( ((adr & 0x00FFEFFF) < 0x70) || ((adr & 0x00FFFFF0) == 0x240) || ((adr & 0x00FFFFFC) == 0x304) )) )
+	{
+		GPU->FinishDeferredLineRender();
+	}
+}
+
 
 #define LOG_VRAM_ERROR() LOG("No data for block %i MST %i\n", block, VRAMBankCnt & 0x07);
 
@@ -786,12 +999,79 @@ void MMU_VRAM_unmap_all()
 		MMU.texInfo.textureSlotAddr[i] = MMU.blank_memory;
 }
 
+void MMU_VRAMMarkDirtyRange(const u32 lcdcOffset, const u32 len)
+{
+	if (len == 0)
+		return;
+
+	const u32 lastPage = std::min<u32>((lcdcOffset + len - 1) >> VRAM_DIRTY_PAGE_SHIFT, VRAM_DIRTY_PAGE_COUNT - 1);
+	for (u32 page = lcdcOffset >> VRAM_DIRTY_PAGE_SHIFT; page <= lastPage; page++)
+	{
+		vram_dirty_map[page >> 5] |= (1 << (page & 31));
+		mmu_snapshot_vram_dirty[page >> 5] |= (1 << (page & 31));
+	}
+}
+
+void MMU_MainMemMarkDirtyRange(const u32 ofs, const u32 len)
+{
+	if (len == 0)
+		return;
+
+	const u32 lastPage = std::min<u32>((ofs + len - 1) >> MMU_SNAPSHOT_PAGE_SHIFT, MMU_SNAPSHOT_MAIN_PAGES - 1);
+	for (u32 page = ofs >> MMU_SNAPSHOT_PAGE_SHIFT; page <= lastPage; page++)
+	{
+		mmu_snapshot_main_dirty[page >> 5] |= (1 << (page & 31));
+		mmu_main_write_gen[page]++;
+	}
+}
+
+void MMU_SnapshotMarkAllDirty()
+{
+	memset(mmu_snapshot_main_dirty, 0xFF, sizeof(mmu_snapshot_main_dirty));
+	for (u32 page = 0; page < MMU_SNAPSHOT_MAIN_PAGES; page++)
+		mmu_main_write_gen[page]++;
+	memset(mmu_snapshot_vram_dirty, 0xFF, sizeof(mmu_snapshot_vram_dirty));
+}
+
+void MMU_SnapshotClearDirty()
+{
+	memset(mmu_snapshot_main_dirty, 0, sizeof(mmu_snapshot_main_dirty));
+	memset(mmu_snapshot_vram_dirty, 0, sizeof(mmu_snapshot_vram_dirty));
+}
+
+void MMU_VRAMMarkAllDirty()
+{
+	MMU_VRAMMarkDirtyRange(0, VRAM_DIRTY_PAGE_COUNT << VRAM_DIRTY_PAGE_SHIFT);
+}
+
+void MMU_VRAMClearDirty()
+{
+	memset(vram_dirty_map, 0, sizeof(vram_dirty_map));
+}
+
+bool MMU_VRAMIsDirty(const void *hostPtr, const u32 len)
+{
+	const size_t lcdcOffset = (const u8 *)hostPtr - MMU.ARM9_LCD;
+	if ( (len == 0) || (lcdcOffset >= (VRAM_DIRTY_PAGE_COUNT << VRAM_DIRTY_PAGE_SHIFT)) )
+		return false;
+
+	const u32 lastPage = std::min<u32>((u32)((lcdcOffset + len - 1) >> VRAM_DIRTY_PAGE_SHIFT), VRAM_DIRTY_PAGE_COUNT - 1);
+	for (u32 page = (u32)(lcdcOffset >> VRAM_DIRTY_PAGE_SHIFT); page <= lastPage; page++)
+	{
+		if (vram_dirty_map[page >> 5] & (1 << (page & 31)))
+			return true;
+	}
+
+	return false;
+}
+
 static inline void MMU_VRAMmapControl(u8 block, u8 VRAMBankCnt)
 {
 	//handle WRAM, first of all
 	if(block == 7)
 	{
 		MMU.WRAMCNT = VRAMBankCnt & 3;
+		MMU_TLBRebuildRange(0x03000000, 0x04000000);
 		return;
 	}
 
@@ -894,6 +1174,8 @@ static inline void MMU_VRAMmapControl(u8 block, u8 VRAMBankCnt)
 	}
 
 	//-------------------------------
+
+	MMU_TLBRebuildRange(0x06000000, 0x07000000);
 }
 
 //////////////////////////////////////////////////////////////
@@ -950,10 +1232,12 @@ void MMU_Reset()
 	memset(MMU.ARM9_DTCM, 0, sizeof(MMU.ARM9_DTCM));
 	memset(MMU.ARM9_ITCM, 0, sizeof(MMU.ARM9_ITCM));
 	memset(MMU.ARM9_LCD,  0, sizeof(MMU.ARM9_LCD));
+	MMU_VRAMMarkAllDirty();
 	memset(MMU.ARM9_OAM,  0, sizeof(MMU.ARM9_OAM));
 	memset(MMU.ARM9_REG,  0, sizeof(MMU.ARM9_REG));
 	memset(MMU.ARM9_VMEM, 0, sizeof(MMU.ARM9_VMEM));
 	memset(MMU.MAIN_MEM,  0, sizeof(MMU.MAIN_MEM));
+	MMU_SnapshotMarkAllDirty();
 
 	memset(MMU.UNUSED_RAM,    0, sizeof(MMU.UNUSED_RAM));
 	memset(MMU.MORE_UNUSED_RAM,    0, sizeof(MMU.UNUSED_RAM));
@@ -1034,6 +1318,8 @@ void MMU_Reset()
 	MMU_timing.arm9dataFetch.Reset();
 	MMU_timing.arm9codeCache.Reset();
 	MMU_timing.arm9dataCache.Reset();
+
+	MMU_TLBRebuild();
 }
 
 void SetupMMU(bool debugConsole, bool dsi) {
@@ -1042,6 +1328,7 @@ void SetupMMU(bool debugConsole, bool dsi) {
 	if(dsi) _MMU_MAIN_MEM_MASK = 0xFFFFFF;
 	_MMU_MAIN_MEM_MASK16 = _MMU_MAIN_MEM_MASK & ~1;
 	_MMU_MAIN_MEM_MASK32 = _MMU_MAIN_MEM_MASK & ~3;
+	MMU_TLBRebuild();
 }
 
 static void execsqrt() {
@@ -2268,6 +2555,87 @@ void DmaController::exec()
 	driver->DEBUG_UpdateIORegView(BaseDriver::EDEBUG_IOREG_DMA);
 }
 
+//a DMA can skip the per-word MMU path only when nothing is watching its accesses
+static FORCEINLINE bool MMU_DMACanCopyInBulk()
+{
+	if (CheckDebugEvent(DEBUG_EVENT_READ) || CheckDebugEvent(DEBUG_EVENT_WRITE))
+		return false;
+	if (!memReadBreakPoints.empty() || !memWriteBreakPoints.empty())
+		return false;
+#ifdef HAVE_LUA
+	if (hookedRegions[LUAMEMHOOK_READ].NotEmpty() || hookedRegions[LUAMEMHOOK_WRITE].NotEmpty())
+		return false;
+#endif
+#ifdef TARGET_INTERFACE
+	if (hooked_regions[HOOK_READ].NotEmpty() || hooked_regions[HOOK_WRITE].NotEmpty())
+		return false;
+#endif
+	return true;
+}
+
+//maps a DMA address to host memory that behaves like plain memory for both reads and writes,
+//along with the number of bytes left before that mapping changes (end of a mirror or VRAM page).
+//returns NULL for TCM, IO, slot-2 and unmapped VRAM, which all need the per-word path.
+template<int PROCNUM>
+static FORCEINLINE u8* MMU_DMABulkMap(const u32 addr, u32 &span)
+{
+	const u32 adr = addr & 0x0FFFFFFF;
+	const u32 adrBank = adr >> 24;
+
+	if (adrBank == 0x02)
+	{
+		const u32 ofs = adr & _MMU_MAIN_MEM_MASK;
+		span = _MMU_MAIN_MEM_MASK + 1 - ofs;
+		return MMU.MAIN_MEM + ofs;
+	}
+
+	//palette, VRAM and OAM
+	if ( (PROCNUM == ARMCPU_ARM9) && (adrBank >= 0x05) && (adrBank <= 0x07) )
+	{
+		bool unmapped, restricted;
+		const u32 mappedAdr = MMU_LCDmap<ARMCPU_ARM9>(adr, unmapped, restricted);
+		if (unmapped)
+			return NULL;
+
+		const u32 mask = MMU.MMU_MASK[ARMCPU_ARM9][mappedAdr >> 20];
+		span = std::min<u32>(0x4000 - (adr & 0x3FFF), mask + 1 - (mappedAdr & mask));
+		return MMU.MMU_MEM[ARMCPU_ARM9][mappedAdr >> 20] + (mappedAdr & mask);
+	}
+
+	return NULL;
+}
+
+//does for a whole span of DMA writes what the write handlers do for each word,
+//other than the store itself. the span must come from MMU_DMABulkMap().
+template<int PROCNUM>
+static FORCEINLINE void MMU_DMABulkWrite(const u32 addr, const u32 len)
+{
+	const u32 adr = addr & 0x0FFFFFFF;
+	const u32 adrBank = adr >> 24;
+
+	if (adrBank == 0x02)
+	{
+#ifdef HAVE_JIT
+		memset(&JIT_COMPILED_FUNC_KNOWNBANK(adr, MAIN_MEM, _MMU_MAIN_MEM_MASK, 0), 0, (len >> 1) * sizeof(uintptr_t));
+#endif
+		MMU_MainMemMarkDirtyRange(adr & _MMU_MAIN_MEM_MASK, len);
+		return;
+	}
+
+	MMU_GPUDeferredLineRenderBarrier(adr, adrBank);
+
+	bool unmapped, restricted;
+	const u32 mappedAdr = MMU_LCDmap<ARMCPU_ARM9>(adr, unmapped, restricted);
+
+#ifdef HAVE_JIT
+	if (JIT_MAPPED(mappedAdr, ARMCPU_ARM9))
+		memset(&JIT_COMPILED_FUNC_PREMASKED(mappedAdr, ARMCPU_ARM9, 0), 0, (len >> 1) * sizeof(uintptr_t));
+#endif
+
+	if (adrBank == 0x06)
+		MMU_VRAMMarkDirtyRange(mappedAdr - LCDC_HACKY_LOCATION, len);
+}
+
 template<int PROCNUM>
 void DmaController::doCopy()
 {
@@ -2323,8 +2691,47 @@ void DmaController::doCopy()
 	//we might make another function to do just the raw copy op which can use them with checks
 	//outside the loop
 	int time_elapsed = 0;
+	u32 left = todo;
+
+	//copy whole runs of plain memory directly. the per-word access time only depends on
+	//the memory region, so each run costs its word count times one read and one write.
+	if(srcinc == sz && dstinc == sz && ((src | dst) & (sz-1)) == 0 && MMU_DMACanCopyInBulk())
+	{
+		while(left > 0)
+		{
+			u32 srcSpan = 0, dstSpan = 0;
+			const u8 *srcPtr = MMU_DMABulkMap<PROCNUM>(src, srcSpan);
+			u8 *dstPtr = MMU_DMABulkMap<PROCNUM>(dst, dstSpan);
+			if(srcPtr == NULL || dstPtr == NULL) break;
+
+			const u32 count = std::min<u32>(left, std::min<u32>(srcSpan, dstSpan) / sz);
+			const u32 len = count * sz;
+
+			//DMA sees zeroes in place of DTCM, and word-by-word copies between overlapping
+			//ranges don't behave like memmove, so leave those to the per-word path
+			if(PROCNUM == ARMCPU_ARM9)
+			{
+				if( (MMU.DTCMRegion >= (src & ~0x3FFF)) && (MMU.DTCMRegion <= ((src + len - 1) & ~0x3FFF)) ) break;
+				if( (MMU.DTCMRegion >= (dst & ~0x3FFF)) && (MMU.DTCMRegion <= ((dst + len - 1) & ~0x3FFF)) ) break;
+			}
+			if( (dstPtr < srcPtr + len) && (srcPtr < dstPtr + len) ) break;
+
+			MMU_DMABulkWrite<PROCNUM>(dst, len);
+			memcpy(dstPtr, srcPtr, len);
+
+			if(sz==4)
+				time_elapsed += count * (_MMU_accesstime<PROCNUM,MMU_AT_DMA,32,MMU_AD_READ,TRUE>(src,true) + _MMU_accesstime<PROCNUM,MMU_AT_DMA,32,MMU_AD_WRITE,TRUE>(dst,true));
+			else
+				time_elapsed += count * (_MMU_accesstime<PROCNUM,MMU_AT_DMA,16,MMU_AD_READ,TRUE>(src,true) + _MMU_accesstime<PROCNUM,MMU_AT_DMA,16,MMU_AD_WRITE,TRUE>(dst,true));
+
+			src += len;
+			dst += len;
+			left -= count;
+		}
+	}
+
 	if(sz==4) {
-		for(s32 i=(s32)todo; i>0; i--)
+		for(s32 i=(s32)left; i>0; i--)
 		{
 			time_elapsed += _MMU_accesstime<PROCNUM,MMU_AT_DMA,32,MMU_AD_READ,TRUE>(src,true);
 			time_elapsed += _MMU_accesstime<PROCNUM,MMU_AT_DMA,32,MMU_AD_WRITE,TRUE>(dst,true);
@@ -2334,7 +2741,7 @@ void DmaController::doCopy()
 			src += srcinc;
 		}
 	} else {
-		for(s32 i=(s32)todo; i>0; i--)
+		for(s32 i=(s32)left; i>0; i--)
 		{
 			time_elapsed += _MMU_accesstime<PROCNUM,MMU_AT_DMA,16,MMU_AD_READ,TRUE>(src,true);
 			time_elapsed += _MMU_accesstime<PROCNUM,MMU_AT_DMA,16,MMU_AD_WRITE,TRUE>(dst,true);
@@ -3319,6 +3726,7 @@ void FASTCALL _MMU_ARM9_write08(u32 adr, u8 val)
 	const u32 adrBank = (adr >> 24);
 
 	mmu_log_debug_ARM9(adr, "(write08) 0x%02X", val);
+	MMU_GPUDeferredLineRenderBarrier(adr, adrBank);
 
 	if (adrBank < 0x02)
 	{
@@ -3845,6 +4253,8 @@ void FASTCALL _MMU_ARM9_write08(u32 adr, u8 val)
 		JIT_COMPILED_FUNC_PREMASKED(adr, ARMCPU_ARM9, 0) = 0;
 #endif
 
+	MMU_MainMemMarkDirtyMapped(adr);
+
 	// Removed the &0xFF as they are implicit with the adr&0x0FFFFFFF [shash]
 	MMU.MMU_MEM[ARMCPU_ARM9][adr>>20][adr&MMU.MMU_MASK[ARMCPU_ARM9][adr>>20]]=val;
 }
@@ -3856,6 +4266,7 @@ void FASTCALL _MMU_ARM9_write16(u32 adr, u16 val)
 	const u32 adrBank = (adr >> 24);
 
 	mmu_log_debug_ARM9(adr, "(write16) 0x%04X", val);
+	MMU_GPUDeferredLineRenderBarrier(adr, adrBank);
 	
 	if (adrBank < 0x02)
 	{
@@ -4561,6 +4972,9 @@ void FASTCALL _MMU_ARM9_write16(u32 adr, u16 val)
 		JIT_COMPILED_FUNC_PREMASKED(adr, ARMCPU_ARM9, 0) = 0;
 #endif
 
+	MMU_VRAMMarkDirtyMapped(adr);
+	MMU_MainMemMarkDirtyMapped(adr);
+
 	// Removed the &0xFF as they are implicit with the adr&0x0FFFFFFF [shash]
 	T1WriteWord(MMU.MMU_MEM[ARMCPU_ARM9][adr>>20], adr&MMU.MMU_MASK[ARMCPU_ARM9][adr>>20], val);
 } 
@@ -4572,6 +4986,7 @@ void FASTCALL _MMU_ARM9_write32(u32 adr, u32 val)
 	const u32 adrBank = (adr >> 24);
 	
 	mmu_log_debug_ARM9(adr, "(write32) 0x%08X", val);
+	MMU_GPUDeferredLineRenderBarrier(adr, adrBank);
 
 	if (adrBank < 0x02)
 	{
@@ -5104,6 +5519,9 @@ void FASTCALL _MMU_ARM9_write32(u32 adr, u32 val)
 	}
 #endif
 
+	MMU_VRAMMarkDirtyMapped(adr);
+	MMU_MainMemMarkDirtyMapped(adr);
+
 	// Removed the &0xFF as they are implicit with the adr&0x0FFFFFFF [shash]
 	T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM9][adr>>20], adr&MMU.MMU_MASK[ARMCPU_ARM9][adr>>20], val);
 }
@@ -5596,6 +6014,9 @@ void FASTCALL _MMU_ARM7_write08(u32 adr, u8 val)
 		JIT_COMPILED_FUNC_PREMASKED(adr, ARMCPU_ARM7, 0) = 0;
 #endif
 	
+	MMU_VRAMMarkDirtyMapped(adr);
+	MMU_MainMemMarkDirtyMapped(adr);
+
 	// Removed the &0xFF as they are implicit with the adr&0x0FFFFFFF [shash]
 	MMU.MMU_MEM[ARMCPU_ARM7][adr>>20][adr&MMU.MMU_MASK[ARMCPU_ARM7][adr>>20]]=val;
 }
@@ -5782,6 +6203,9 @@ void FASTCALL _MMU_ARM7_write16(u32 adr, u16 val)
 		JIT_COMPILED_FUNC_PREMASKED(adr, ARMCPU_ARM7, 0) = 0;
 #endif
 
+	MMU_VRAMMarkDirtyMapped(adr);
+	MMU_MainMemMarkDirtyMapped(adr);
+
 	// Removed the &0xFF as they are implicit with the adr&0x0FFFFFFF [shash]
 	T1WriteWord(MMU.MMU_MEM[ARMCPU_ARM7][adr>>20], adr&MMU.MMU_MASK[ARMCPU_ARM7][adr>>20], val);
 }
@@ -5884,6 +6308,9 @@ void FASTCALL _MMU_ARM7_write32(u32 adr, u32 val)
 	}
 #endif
 
+	MMU_VRAMMarkDirtyMapped(adr);
+	MMU_MainMemMarkDirtyMapped(adr);
+
 	// Removed the &0xFF as they are implicit with the adr&0x0FFFFFFF [shash]
 	T1WriteLong(MMU.MMU_MEM[ARMCPU_ARM7][adr>>20], adr&MMU.MMU_MASK[ARMCPU_ARM7][adr>>20], val);
 }
@@ -606,6 +606,56 @@ extern VramConfiguration vramConfiguration;
 
 #define VRAM_ARM9_PAGES 512
 extern u8 vram_arm9_map[VRAM_ARM9_PAGES];
+
+//VRAM writes are tracked in 4KB pages of the LCDC buffer (ARM9_LCD), so that consumers
+//such as the texture cache only need to re-check data that could actually have changed.
+//the dirty bits accumulate until the consumer clears them with MMU_VRAMClearDirty().
+#define VRAM_DIRTY_PAGE_SHIFT 12
+#define VRAM_DIRTY_PAGE_COUNT (0xA4000 >> VRAM_DIRTY_PAGE_SHIFT)
+#define VRAM_DIRTY_MAP_SIZE ((VRAM_DIRTY_PAGE_COUNT + 31) / 32)
+extern u32 vram_dirty_map[VRAM_DIRTY_MAP_SIZE];
+
+//separately from the map above, which belongs to the texture cache, writes to main RAM and to the
+//LCDC buffer are tracked in the same 4KB pages for incremental snapshots (see snapshot_take_incremental()).
+//these bits are only cleared by the snapshot code, with MMU_SnapshotClearDirty().
+#define MMU_SNAPSHOT_PAGE_SHIFT VRAM_DIRTY_PAGE_SHIFT
+#define MMU_SNAPSHOT_MAIN_PAGES (sizeof(MMU.MAIN_MEM) >> MMU_SNAPSHOT_PAGE_SHIFT)
+extern u32 mmu_snapshot_main_dirty[MMU_SNAPSHOT_MAIN_PAGES / 32];
+extern u32 mmu_snapshot_vram_dirty[VRAM_DIRTY_MAP_SIZE];
+
+//every main RAM write marked above also bumps its page's generation, which nothing ever resets,
+//so that the cached interpreter can tell whether a block decoded from that page is still current
+extern u32 mmu_main_write_gen[MMU_SNAPSHOT_MAIN_PAGES];
+
+FORCEINLINE void MMU_VRAMMarkDirty(const u32 lcdcOffset)
+{
+	const u32 page = lcdcOffset >> VRAM_DIRTY_PAGE_SHIFT;
+	if (page < VRAM_DIRTY_PAGE_COUNT)
+	{
+		vram_dirty_map[page >> 5] |= (1 << (page & 31));
+		mmu_snapshot_vram_dirty[page >> 5] |= (1 << (page & 31));
+	}
+}
+
+//takes an offset into MAIN_MEM, already masked
+FORCEINLINE void MMU_MainMemMarkDirty(const u32 ofs)
+{
+	const u32 page = (ofs >> MMU_SNAPSHOT_PAGE_SHIFT) & (MMU_SNAPSHOT_MAIN_PAGES - 1);
+	mmu_snapshot_main_dirty[page >> 5] |= (1 << (page & 31));
+	mmu_main_write_gen[page]++;
+}
+
+void MMU_MainMemMarkDirtyRange(const u32 ofs, const u32 len);
+void MMU_SnapshotMarkAllDirty();
+void MMU_SnapshotClearDirty();
+
+void MMU_VRAMMarkDirtyRange(const u32 lcdcOffset, const u32 len);
+void MMU_VRAMMarkAllDirty();
+void MMU_VRAMClearDirty();
+
+//checks a span of host memory for dirty pages. spans outside of the LCDC buffer
+//(such as the blank memory used for unmapped slots) are never dirty.
+bool MMU_VRAMIsDirty(const void *hostPtr, const u32 len);
 FORCEINLINE void* MMU_gpu_map(const u32 vram_addr)
 {
 	//this is supposed to map a single gpu vram address to emulator host memory
@@ -666,6 +716,57 @@ extern u32 _MMU_MAIN_MEM_MASK16;
 extern u32 _MMU_MAIN_MEM_MASK32;
 void SetupMMU(bool debugConsole, bool dsi);
 
+//software TLB: for each 16KB page of the address space, a host pointer to the plain memory behind it,
+//so that most loads and stores skip the hook checks and the chain of region tests in the functions below.
+//a NULL entry sends the access down the full path. that covers I/O, slot-2, unmapped memory, anything which
+//mirrors inside of a page, the ARM7 bios, the pages memory hooks cover, and everything while breakpoints or
+//debug events are installed.
+//only pages of the low 256MB are ever filled in; mirrors above that are rare enough to take the full path.
+//the write table only holds RAM whose writes need nothing but a store, clearing the compiled code at that
+//address (through mmu_tlb_jit) and marking the snapshot page.
+//every page is 16KB since nothing the NDS maps (VRAM pages, shared WRAM blocks, DTCM) is any smaller.
+#define MMU_TLB_PAGE_SHIFT 14
+#define MMU_TLB_PAGE_MASK ((1 << MMU_TLB_PAGE_SHIFT) - 1)
+#define MMU_TLB_PAGES (1 << (32 - MMU_TLB_PAGE_SHIFT))
+extern u8 *mmu_tlb_read[2][MMU_TLB_PAGES];
+extern u8 *mmu_tlb_write[2][MMU_TLB_PAGES];
+#ifdef HAVE_JIT
+extern uintptr_t *mmu_tlb_jit[2][MMU_TLB_PAGES];
+#endif
+
+//rebuilds both CPUs' tables. this happens on its own when VRAMCNT, WRAMCNT, the DTCM region or the size of main RAM change,
+//and has to be called whenever the memory hooks change
+void MMU_TLBRebuild();
+//rebuilds the tables if breakpoints or debug events were installed or removed since the last rebuild.
+//call it right after changing them, outside of NDS_exec(); the start of every frame calls it too, as a fallback
+void MMU_TLBSync();
+
+//the ARM9 fetches code from main RAM underneath DTCM and DMA can't see the TCMs at all, so those can't use the tables
+#define MMU_TLB_USABLE(PROCNUM, AT) ((PROCNUM) == ARMCPU_ARM7 || ((AT) != MMU_AT_CODE && (AT) != MMU_AT_DMA))
+
+template<int PROCNUM, int SIZE>
+FORCEINLINE bool MMU_TLBWrite(const u32 addr, const u32 val)
+{
+	u8 *const page = mmu_tlb_write[PROCNUM][addr >> MMU_TLB_PAGE_SHIFT];
+	if (page == NULL)
+		return false;
+
+	const u32 ofs = addr & MMU_TLB_PAGE_MASK & ~(SIZE/8 - 1);
+#ifdef HAVE_JIT
+	uintptr_t *const jit = mmu_tlb_jit[PROCNUM][addr >> MMU_TLB_PAGE_SHIFT];
+	jit[ofs >> 1] = 0;
+	if (SIZE == 32) jit[(ofs >> 1) + 1] = 0;
+#endif
+	if (SIZE == 8) T1WriteByte(page, ofs, (u8)val);
+	else if (SIZE == 16) T1WriteWord(page, ofs, (u16)val);
+	else T1WriteLong(page, ofs, val);
+
+	//only main RAM is tracked for snapshots
+	if ((addr & 0x0F000000) == 0x02000000)
+		MMU_MainMemMarkDirty(addr & _MMU_MAIN_MEM_MASK);
+	return true;
+}
+
 FORCEINLINE void CheckMemoryDebugEvent(EDEBUG_EVENT event, const MMU_ACCESS_TYPE type, const u32 procnum, const u32 addr, const u32 size, const u32 val)
 {
 	//TODO - ugh work out a better prefetch event system
@@ -689,6 +790,12 @@ FORCEINLINE void CheckMemoryDebugEvent(EDEBUG_EVENT event, const MMU_ACCESS_TYPE
 
 FORCEINLINE u8 _MMU_read08(const int PROCNUM, const MMU_ACCESS_TYPE AT, const u32 addr)
 {
+	if(MMU_TLB_USABLE(PROCNUM, AT))
+	{
+		const u8 *page = mmu_tlb_read[PROCNUM][addr >> MMU_TLB_PAGE_SHIFT];
+		if(page) return T1ReadByte((u8*)page, addr & MMU_TLB_PAGE_MASK);
+	}
+
 	CheckMemoryDebugEvent(DEBUG_EVENT_READ,AT,PROCNUM,addr,8,0);
 
 	//special handling to un-protect the ARM7 bios during debug reading
@@ -737,6 +844,12 @@ FORCEINLINE u8 _MMU_read08(const int PROCNUM, const MMU_ACCESS_TYPE AT, const u3
 
 FORCEINLINE u16 _MMU_read16(const int PROCNUM, const MMU_ACCESS_TYPE AT, const u32 addr) 
 {
+	if(MMU_TLB_USABLE(PROCNUM, AT))
+	{
+		const u8 *page = mmu_tlb_read[PROCNUM][addr >> MMU_TLB_PAGE_SHIFT];
+		if(page) return T1ReadWord_guaranteedAligned((u8*)page, addr & MMU_TLB_PAGE_MASK & ~1);
+	}
+
 	CheckMemoryDebugEvent(DEBUG_EVENT_READ,AT,PROCNUM,addr,16,0);
 
 	//special handling to un-protect the ARM7 bios during debug reading
@@ -798,6 +911,12 @@ dunno:
 
 FORCEINLINE u32 _MMU_read32(const int PROCNUM, const MMU_ACCESS_TYPE AT, const u32 addr)
 {
+	if(MMU_TLB_USABLE(PROCNUM, AT))
+	{
+		const u8 *page = mmu_tlb_read[PROCNUM][addr >> MMU_TLB_PAGE_SHIFT];
+		if(page) return T1ReadLong_guaranteedAligned((u8*)page, addr & MMU_TLB_PAGE_MASK & ~3);
+	}
+
 	CheckMemoryDebugEvent(DEBUG_EVENT_READ,AT,PROCNUM,addr,32,0);
 
 	//special handling to un-protect the ARM7 bios during debug reading
@@ -875,6 +994,12 @@ dunno:
 
 FORCEINLINE void _MMU_write08(const int PROCNUM, const MMU_ACCESS_TYPE AT, const u32 addr, u8 val)
 {
+	if(MMU_TLB_USABLE(PROCNUM, AT))
+	{
+		if(PROCNUM==ARMCPU_ARM9 ? MMU_TLBWrite<ARMCPU_ARM9,8>(addr,val) : MMU_TLBWrite<ARMCPU_ARM7,8>(addr,val))
+			return;
+	}
+
 	CheckMemoryDebugEvent(DEBUG_EVENT_WRITE,AT,PROCNUM,addr,8,val);
 
 	//special handling for DMA: discard writes to TCM
@@ -912,6 +1037,7 @@ FORCEINLINE void _MMU_write08(const int PROCNUM, const MMU_ACCESS_TYPE AT, const
 		JIT_COMPILED_FUNC_KNOWNBANK(addr, MAIN_MEM, _MMU_MAIN_MEM_MASK, 0) = 0;
 #endif
 		T1WriteByte( MMU.MAIN_MEM, addr & _MMU_MAIN_MEM_MASK, val);
+		MMU_MainMemMarkDirty(addr & _MMU_MAIN_MEM_MASK);
 #ifdef HAVE_LUA
 		CallRegisteredLuaMemHook(addr, 1, val, LUAMEMHOOK_WRITE);
 #endif
@@ -933,6 +1059,12 @@ FORCEINLINE void _MMU_write08(const int PROCNUM, const MMU_ACCESS_TYPE AT, const
 
 FORCEINLINE void _MMU_write16(const int PROCNUM, const MMU_ACCESS_TYPE AT, const u32 addr, u16 val)
 {
+	if(MMU_TLB_USABLE(PROCNUM, AT))
+	{
+		if(PROCNUM==ARMCPU_ARM9 ? MMU_TLBWrite<ARMCPU_ARM9,16>(addr,val) : MMU_TLBWrite<ARMCPU_ARM7,16>(addr,val))
+			return;
+	}
+
 	CheckMemoryDebugEvent(DEBUG_EVENT_WRITE,AT,PROCNUM,addr,16,val);
 
 	//special handling for DMA: discard writes to TCM
@@ -970,6 +1102,7 @@ FORCEINLINE void _MMU_write16(const int PROCNUM, const MMU_ACCESS_TYPE AT, const
 		JIT_COMPILED_FUNC_KNOWNBANK(addr, MAIN_MEM, _MMU_MAIN_MEM_MASK16, 0) = 0;
 #endif
 		T1WriteWord( MMU.MAIN_MEM, addr & _MMU_MAIN_MEM_MASK16, val);
+		MMU_MainMemMarkDirty(addr & _MMU_MAIN_MEM_MASK16);
 #ifdef HAVE_LUA
 		CallRegisteredLuaMemHook(addr, 2, val, LUAMEMHOOK_WRITE);
 #endif
@@ -988,6 +1121,12 @@ FORCEINLINE void _MMU_write16(const int PROCNUM, const MMU_ACCESS_TYPE AT, const
 
 FORCEINLINE void _MMU_write32(const int PROCNUM, const MMU_ACCESS_TYPE AT, const u32 addr, u32 val)
 {
+	if(MMU_TLB_USABLE(PROCNUM, AT))
+	{
+		if(PROCNUM==ARMCPU_ARM9 ? MMU_TLBWrite<ARMCPU_ARM9,32>(addr,val) : MMU_TLBWrite<ARMCPU_ARM7,32>(addr,val))
+			return;
+	}
+
 	CheckMemoryDebugEvent(DEBUG_EVENT_WRITE,AT,PROCNUM,addr,32,val);
 
 	//special handling for DMA: discard writes to TCM
@@ -1026,6 +1165,7 @@ FORCEINLINE void _MMU_write32(const int PROCNUM, const MMU_ACCESS_TYPE AT, const
 		JIT_COMPILED_FUNC_KNOWNBANK(addr, MAIN_MEM, _MMU_MAIN_MEM_MASK32, 1) = 0;
 #endif
 		T1WriteLong( MMU.MAIN_MEM, addr & _MMU_MAIN_MEM_MASK32, val);
+		MMU_MainMemMarkDirty(addr & _MMU_MAIN_MEM_MASK32);
 #ifdef HAVE_LUA
 		CallRegisteredLuaMemHook(addr, 4, val, LUAMEMHOOK_WRITE);
 #endif
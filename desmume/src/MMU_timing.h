@@ -239,6 +239,9 @@ public:
 		return true;
 	}
 
+	// the JIT keeps this up to date itself when it inlines an access
+	u32& lastAddress() { return m_lastAddress; }
+
 private:
 	u32 m_lastAddress;
 };
@@ -24,6 +24,7 @@
 #include <zlib.h>
 
 #include <features/features_cpu.h>
+#include <rthreads/rthreads.h>
 
 #include "utils/decrypt/decrypt.h"
 #include "utils/decrypt/crc.h"
@@ -57,6 +58,7 @@
 #include "emufile.h"
 #include "SPU.h"
 #include "wifi.h"
+#include "saves.h"
 #include "Database.h"
 #include "frontend/modules/Disassembler.h"
 
@@ -96,6 +98,9 @@ std::string InputDisplayString;
 static BOOL LidClosed = FALSE;
 static u8 countLid = 0;
 static NDSError _lastNDSError;
+static NDSInstance *_residentInstance = NULL;
+static std::vector<NDSInstance *> _instanceSlots; //indexed by instance ID, NULL for a free ID
+static slock_t *_coreMutex = slock_new(); //created up front, so that the core can be locked before NDS_Init()
 
 GameInfo gameInfo;
 NDSSystem nds;
@@ -530,6 +535,11 @@ bool GameInfo::loadROM(std::string fname, u32 type)
 		if(isHomebrew())
 			loadToMemory = true;
 
+		//a mapped rom is already in memory, shared with every other process that has it open,
+		//so a private copy is only needed when it has to be patched
+		if (loadToMemory && !isHomebrew() && reader->Data != NULL && reader->Data(fROM) != NULL)
+			loadToMemory = false;
+
 		//convert to an in-memory reader around a pre-read buffer if that's what's requested
 		if (loadToMemory)
 		{
@@ -550,6 +560,9 @@ bool GameInfo::loadROM(std::string fname, u32 type)
 			fROM = reader->Init(NULL);
 		}
 
+		if (reader->Data != NULL && (romdataDirect = (const u8 *)reader->Data(fROM)) != NULL)
+			romdataDirectSize = reader->Size(fROM);
+
 		if(hasRomBanner())
 		{
 			reader->Seek(fROM, header.IconOff, SEEK_SET);
@@ -604,6 +617,8 @@ void GameInfo::closeROM()
 	fROM = NULL;
 	reader = NULL;
 	romdataForReader = NULL;
+	romdataDirect = NULL;
+	romdataDirectSize = 0;
 	romsize = 0;
 }
 
@@ -612,6 +627,12 @@ u32 GameInfo::readROM(u32 pos)
 	u32 num;
 	u32 data;
 
+	if (romdataDirect != NULL && romdataDirectSize >= 4 && pos <= romdataDirectSize - 4)
+	{
+		memcpy(&data, romdataDirect + pos, 4);
+		return LE_TO_LOCAL_32(data);
+	}
+
 	//reader must try to be efficient and not do unneeded seeks
 	reader->Seek(fROM, pos, SEEK_SET);
 	num = reader->Read(fROM, &data, 4);
@@ -815,6 +836,7 @@ void NDS_FreeROM(void)
 	FCEUI_StopMovie();
 	gameInfo.closeROM();
 	UnloadMovieEmulationSettings();
+	rewind_clear();
 }
 
 void NDS_Sleep() { nds.sleeping = TRUE; }
@@ -1645,6 +1667,13 @@ void NDS_Reschedule()
 {
 	IF_DEVELOPER(if(!sequencer.reschedule) DEBUG_statistics.sequencerExecutionCounters[0]++;);
 	sequencer.reschedule = true;
+	armcpu_execBudget[ARMCPU_ARM9] = 0;
+	armcpu_execBudget[ARMCPU_ARM7] = 0;
+#ifdef HAVE_JIT
+	// stop any chain of linked blocks at its next link
+	JIT_LINK[ARMCPU_ARM9].budget = 0;
+	JIT_LINK[ARMCPU_ARM7].budget = 0;
+#endif
 }
 
 FORCEINLINE u32 _fast_min32(u32 a, u32 b, u32 c, u32 d)
@@ -1906,6 +1935,24 @@ static FORCEINLINE s32 minarmtime(s32 arm9, s32 arm7)
 		return arm7;
 }
 
+// Cycles that linked JIT blocks or cached interpreter blocks may run through
+// before armInnerLoop() would have switched to the other CPU or reached the
+// end of the slice.
+template<bool doarm9, bool doarm7, int PROCNUM>
+static FORCEINLINE s32 armexecbudget(s32 arm9, s32 arm7, s32 s32next)
+{
+#if defined(HOST_WINDOWS) && !defined(TARGET_INTERFACE)
+	// breakpoints and stepping are only checked between dispatches
+	const armcpu_t &armcpu = (PROCNUM == ARMCPU_ARM9) ? NDS_ARM9 : NDS_ARM7;
+	if (!armcpu.breakPoints->empty() || armcpu.debugStep || armcpu.stepOverBreak != 0 || armcpu.runToRetTmp != 0)
+		return 0;
+#endif
+	if(PROCNUM == ARMCPU_ARM9)
+		return (doarm7 ? min(arm7 + 1, s32next) : s32next) - arm9;
+	else
+		return ((doarm9 ? min(arm9, s32next) : s32next) - arm7 + 1) >> 1;
+}
+
 #ifdef HAVE_JIT
 template<bool doarm9, bool doarm7, bool jit>
 #else
@@ -1952,9 +1999,11 @@ static /*donotinline*/ std::pair<s32,s32> armInnerLoop(
 				arm9log();
 				debug();
 #ifdef HAVE_JIT
-				arm9 += armcpu_exec<ARMCPU_ARM9,jit>();
+				arm9 += armcpu_exec<ARMCPU_ARM9,jit>(armexecbudget<doarm9,doarm7,ARMCPU_ARM9>(arm9, arm7, s32next));
 #else
-				arm9 += armcpu_exec<ARMCPU_ARM9>();
+				arm9 += CommonSettings.use_cached_interpreter
+					? armcpu_execCached<ARMCPU_ARM9>(armexecbudget<doarm9,doarm7,ARMCPU_ARM9>(arm9, arm7, s32next))
+					: armcpu_exec<ARMCPU_ARM9>();
 #endif
 				#ifdef DEVELOPER
 					nds_debug_continuing[0] = false;
@@ -1993,9 +2042,11 @@ static /*donotinline*/ std::pair<s32,s32> armInnerLoop(
 			{
 				arm7log();
 #ifdef HAVE_JIT
-				arm7 += (armcpu_exec<ARMCPU_ARM7,jit>()<<1);
+				arm7 += (armcpu_exec<ARMCPU_ARM7,jit>(armexecbudget<doarm9,doarm7,ARMCPU_ARM7>(arm9, arm7, s32next))<<1);
 #else
-				arm7 += (armcpu_exec<ARMCPU_ARM7>()<<1);
+				arm7 += (CommonSettings.use_cached_interpreter
+					? armcpu_execCached<ARMCPU_ARM7>(armexecbudget<doarm9,doarm7,ARMCPU_ARM7>(arm9, arm7, s32next))
+					: armcpu_exec<ARMCPU_ARM7>())<<1;
 #endif
 				#ifdef DEVELOPER
 					nds_debug_continuing[1] = false;
@@ -2073,6 +2124,14 @@ void NDS_exec(s32 nb)
 
 	nds.cpuloopIterationCount = 0;
 
+	//catches breakpoints or debug events changed without a call to MMU_TLBSync() of their own
+	MMU_TLBSync();
+#ifdef HAVE_JIT
+	//and so does a change to advanced timing, which the compiled blocks have built in
+	if (CommonSettings.use_jit)
+		arm_jit_sync_timing();
+#endif
+
 	IF_DEVELOPER(for(int i=0;i<32;i++) DEBUG_statistics.sequencerExecutionCounters[i] = 0);
 
 	if(nds.sleeping)
@@ -2205,6 +2264,7 @@ void NDS_exec(s32 nb)
 		cheats->process(CHEAT_TYPE_INTERNAL);
 		CHEATS::ResetJitIfNeeded();
 	}
+	rewind_frame();
 
 	GDBSTUB_MUTEX_UNLOCK();
 }
@@ -3155,6 +3215,8 @@ void NDS_suspendProcessingInput(bool suspend)
 
 void NDS_swapScreen()
 {
+	GPU->FinishDeferredLineRender();
+	
 	if (GPU->GetDisplayMain()->GetEngineID() == GPUEngineID_Main)
 	{
 		GPU->GetDisplayMain()->SetEngineByID(GPUEngineID_Sub);
@@ -3294,6 +3356,120 @@ void NDS_GetCPULoadAverage(u32 &outLoadAvgARM9, u32 &outLoadAvgARM7)
 	outLoadAvgARM7 = std::min<u32>( 100, std::max<u32>(0, (u32)(calcLoad*100/1120380)) );
 }
 
+NDSInstance::NDSInstance(u32 instanceID)
+{
+	_parkedState = snapshot_create();
+	_isParked = false;
+	_instanceID = instanceID;
+}
+
+NDSInstance::~NDSInstance()
+{
+	snapshot_destroy(_parkedState);
+}
+
+u32 NDSInstance::GetID() const
+{
+	return _instanceID;
+}
+
+bool NDSInstance::IsResident() const
+{
+	return (_residentInstance == this);
+}
+
+bool NDSInstance::Park()
+{
+	_isParked = snapshot_take(_parkedState);
+	return _isParked;
+}
+
+bool NDSInstance::Unpark()
+{
+	if (!_isParked)
+		return false;
+	
+	// Switch to this instance's save file first, since restoring the backup device's state writes
+	// the parked save data back out to whichever file is open.
+	backup_selectInstanceFile(_instanceID);
+	return snapshot_restore(_parkedState);
+}
+
+NDSInstance* NDS_CreateInstance()
+{
+	// Take the lowest free ID, so that the same instance keeps the same save file from run to run.
+	u32 instanceID = 0;
+	while ( (instanceID < _instanceSlots.size()) && (_instanceSlots[instanceID] != NULL) )
+		instanceID++;
+	
+	NDSInstance *newInstance = new NDSInstance(instanceID);
+	if (!newInstance->Park())
+	{
+		delete newInstance;
+		return NULL;
+	}
+	
+	if (instanceID == _instanceSlots.size())
+		_instanceSlots.push_back(newInstance);
+	else
+		_instanceSlots[instanceID] = newInstance;
+	
+	return newInstance;
+}
+
+void NDS_DestroyInstance(NDSInstance *instance)
+{
+	if (instance == NULL)
+		return;
+	
+	// The core keeps the state of a destroyed resident instance, but nobody owns it anymore.
+	if (instance->IsResident())
+		_residentInstance = NULL;
+	
+	_instanceSlots[instance->GetID()] = NULL;
+	delete instance;
+}
+
+bool NDS_SelectInstance(NDSInstance *instance)
+{
+	if ( (instance == NULL) || instance->IsResident() )
+		return (instance != NULL);
+	
+	NDSInstance *previousInstance = _residentInstance;
+	if ( (previousInstance != NULL) && !previousInstance->Park() )
+		return false;
+	
+	// The rewind buffer is a single one for the core, and its states belong to the previous instance.
+	rewind_clear();
+	
+	if (!instance->Unpark())
+	{
+		// A failed load may have left the core half-written, so put the previous state back.
+		if ( (previousInstance != NULL) && !previousInstance->Unpark() )
+			_residentInstance = NULL;
+		
+		return false;
+	}
+	
+	_residentInstance = instance;
+	return true;
+}
+
+NDSInstance* NDS_GetResidentInstance()
+{
+	return _residentInstance;
+}
+
+void NDS_LockCore()
+{
+	slock_lock(_coreMutex);
+}
+
+void NDS_UnlockCore()
+{
+	slock_unlock(_coreMutex);
+}
+
 //these templates needed to be instantiated manually
 template void NDS_exec<FALSE>(s32 nb);
 template void NDS_exec<TRUE>(s32 nb);
@@ -29,6 +29,7 @@
 
 class CFIRMWARE;
 class EMUFILE;
+class EMUFILE_MEMORY;
 
 template<typename Type>
 struct buttonstruct {
@@ -332,6 +333,8 @@ struct GameInfo
 	void *fROM;
 	ROMReader_struct *reader;
 	u8 *romdataForReader;
+	const u8 *romdataDirect; //the reader's own buffer, if it has one, so readROM() can skip the seek and read
+	u32 romdataDirectSize;
 	u32 romsize;
 	u32 cardSize;
 	u32 mask;
@@ -351,6 +354,8 @@ struct GameInfo
 
 	GameInfo() :	fROM(NULL),
 					romdataForReader(NULL),
+					romdataDirect(NULL),
+					romdataDirectSize(0),
 					crc(0),
 					chipID(0x00000FC2),
 					romsize(0),
@@ -493,6 +498,61 @@ void NDS_SetupDefaultFirmware();
 
 template<bool FORCE> void NDS_exec(s32 nb = 560190<<1);
 
+struct savestate_snapshot;
+
+// An NDSInstance is one independent emulated console, held as a saved state that
+// can be swapped into the core. The hardware state that drives emulation (MMU,
+// NDS_ARM9/NDS_ARM7, the sequencer, gfx3d, SPU, etc.) is process-wide, and the JIT
+// compiles its addresses directly into the generated code, so there is only ever
+// one running console: exactly one instance is resident in the core at any time,
+// and selecting an instance parks the state of the resident one (as an in-memory
+// snapshot, see snapshot_take()) and restores the selected one over it. Instances
+// therefore run one after the other, never concurrently.
+//
+// The ROM image, BIOS, firmware and CommonSettings are shared by all instances.
+// Each instance has its own save file: instance 0 uses the ROM's .dsv, and
+// instance N uses "<ROM name>.N.dsv" next to it.
+//
+// Switching instances is not thread-safe by itself; callers driving the core from
+// several threads must serialize access to it (see NDS_LockCore()).
+class NDSInstance
+{
+private:
+	savestate_snapshot *_parkedState;
+	bool _isParked;
+	u32 _instanceID;
+
+public:
+	NDSInstance(u32 instanceID);
+	~NDSInstance();
+
+	u32 GetID() const;
+	bool IsResident() const;
+
+	bool Park();
+	bool Unpark();
+};
+
+// Creates a new instance holding a copy of the state currently in the core, with
+// the lowest instance ID not taken by another live instance. The new instance is
+// parked; the currently resident instance is unchanged.
+NDSInstance* NDS_CreateInstance();
+
+// Destroying the resident instance leaves its state running in the core, still on
+// its save file, until another instance is selected.
+void NDS_DestroyInstance(NDSInstance *instance);
+
+// Makes the given instance resident, parking the previous one. If no instance
+// was resident, whatever state was in the core is discarded. The rewind buffer
+// is cleared, since it only holds states of the previous instance.
+// On failure, the previous instance remains resident.
+bool NDS_SelectInstance(NDSInstance *instance);
+NDSInstance* NDS_GetResidentInstance();
+
+// The core lock is usable at any time, including before NDS_Init().
+void NDS_LockCore();
+void NDS_UnlockCore();
+
 extern int lagframecounter;
 
 extern struct TCommonSettings
@@ -507,12 +567,18 @@ extern struct TCommonSettings
 		, GFX3D_Renderer_TextureScalingFactor(1) // Possible values: 1, 2, 4
 		, GFX3D_Renderer_TextureDeposterize(false)
 		, GFX3D_Renderer_TextureSmoothing(false)
+		, GFX3D_Renderer_TextureParallelUnpack(true)
 		, GFX3D_TXTHack(false)
+		, GPU_DeferLineRender(false)
+		, GPU_RenderEnginesInParallel(false)
 		, OpenGL_Emulation_ShadowPolygon(true)
 		, OpenGL_Emulation_SpecialZeroAlphaBlending(true)
 		, OpenGL_Emulation_NDSDepthCalculation(true)
 		, OpenGL_Emulation_DepthLEqualPolygonFacing(false)
 		, jit_max_block_size(12)
+		, jit_tiered(false)
+		, use_cached_interpreter(false)
+		, skip_idle_loops(false)
 		, loadToMemory(false)
 		, UseExtBIOS(false)
 		, SWIFromBIOS(false)
@@ -524,6 +590,7 @@ extern struct TCommonSettings
 		, DebugConsole(false)
 		, EnsataEmulation(false)
 		, cheatsDisable(false)
+		, savestate_compression(6)
 		, rigorous_timing(false)
 		, advanced_timing(true)
 		, micMode(InternalNoise)
@@ -535,6 +602,8 @@ extern struct TCommonSettings
 		, StylusPressure(50)
 		, ConsoleType(NDS_CONSOLE_TYPE_FAT)
 		, backupSave(false)
+		, backupFlushInterval(1000)
+		, fatDirLazy(false)
 		, SPU_sync_mode(1)
 		, SPU_sync_method(0)
 		, WifiBridgeDeviceID(0)
@@ -542,6 +611,7 @@ extern struct TCommonSettings
 		strcpy(ARM9BIOS, "biosnds9.bin");
 		strcpy(ARM7BIOS, "biosnds7.bin");
 		strcpy(ExtFirmwarePath, "firmware.bin");
+		GFX3D_Renderer_TextureCachePath[0] = '\0';
 
 		for(int i=0;i<16;i++)
 			spu_muteChannels[i] = false;
@@ -569,7 +639,11 @@ extern struct TCommonSettings
 	int GFX3D_Renderer_TextureScalingFactor; //must be one of {1,2,4}
 	bool GFX3D_Renderer_TextureDeposterize;
 	bool GFX3D_Renderer_TextureSmoothing;
+	bool GFX3D_Renderer_TextureParallelUnpack; // SoftRasterizer only: unpack new textures on the rasterizer threads
+	char GFX3D_Renderer_TextureCachePath[MAX_PATH]; // Directory for upscaled textures kept between sessions; empty to disable
 	bool GFX3D_TXTHack;
+	bool GPU_DeferLineRender; // render 2D lines on a worker thread; see GPUSubsystem::SetWillDeferLineRender()
+	bool GPU_RenderEnginesInParallel; // render the sub 2D engine on its own thread; see GPUSubsystem::SetWillRenderEnginesInParallel()
 	
 	bool OpenGL_Emulation_ShadowPolygon;
 	bool OpenGL_Emulation_SpecialZeroAlphaBlending;
@@ -600,6 +674,7 @@ extern struct TCommonSettings
 
 	int num_cores;
 	bool single_core() { return num_cores==1; }
+	int savestate_compression; // zlib level (0-9) for savestate files; 1 is the fastest, for quick saves
 	bool rigorous_timing;
 
 	struct GameHacks {
@@ -627,6 +702,9 @@ extern struct TCommonSettings
 
 	bool use_jit;
 	u32	jit_max_block_size;
+	bool jit_tiered; // interpret cold code, compile warm blocks, recompile hot ones as superblocks
+	bool use_cached_interpreter; // interpreter only: run predecoded blocks instead of one instruction per dispatch
+	bool skip_idle_loops; // JIT and cached interpreter: loops that only poll memory give up the rest of their time slice
 	
 	int WifiBridgeDeviceID;
 
@@ -648,6 +726,10 @@ extern struct TCommonSettings
 	//this is the user's choice of manual backup type, for cases when the autodetection can't be trusted
 	int manualBackupType;
 	bool backupSave;
+	//how many ms the save file on disk may lag behind the backup memory; 0 waits for the game to finish a write command
+	int backupFlushInterval;
+	//directories mounted as slot-1/slot-2 FAT images read file contents from the host on demand instead of at startup
+	bool fatDirLazy;
 
 	int SPU_sync_mode;
 	int SPU_sync_method;
@@ -848,7 +848,7 @@ void OpenGLTexture::Load(bool forceTextureInit)
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1);
 			
-			this->_Upscale<2>(textureSrc, this->_upscaleBuffer);
+			this->_UpscaleUsingCache<2>(textureSrc, this->_upscaleBuffer);
 			
 			if (forceTextureInit || !this->_isTexInited)
 			{
@@ -869,14 +869,14 @@ void OpenGLTexture::Load(bool forceTextureInit)
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 2);
 			
-			this->_Upscale<4>(textureSrc, this->_upscaleBuffer);
+			this->_UpscaleUsingCache<4>(textureSrc, this->_upscaleBuffer);
 			
 			if (forceTextureInit || !this->_isTexInited)
 			{
 				this->_isTexInited = true;
 				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, this->_sizeS*4, this->_sizeT*4, 0, GL_RGBA, GL_TEXTURE_SRC_FORMAT, this->_upscaleBuffer);
 				
-				this->_Upscale<2>(textureSrc, this->_upscaleBuffer);
+				this->_UpscaleUsingCache<2>(textureSrc, this->_upscaleBuffer);
 				glTexImage2D(GL_TEXTURE_2D, 1, GL_RGBA, this->_sizeS*2, this->_sizeT*2, 0, GL_RGBA, GL_TEXTURE_SRC_FORMAT, this->_upscaleBuffer);
 				
 				glTexImage2D(GL_TEXTURE_2D, 2, GL_RGBA, this->_sizeS*1, this->_sizeT*1, 0, GL_RGBA, GL_TEXTURE_SRC_FORMAT, textureSrc);
@@ -885,7 +885,7 @@ void OpenGLTexture::Load(bool forceTextureInit)
 			{
 				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, this->_sizeS*4, this->_sizeT*4, GL_RGBA, GL_TEXTURE_SRC_FORMAT, this->_upscaleBuffer);
 				
-				this->_Upscale<2>(textureSrc, this->_upscaleBuffer);
+				this->_UpscaleUsingCache<2>(textureSrc, this->_upscaleBuffer);
 				glTexSubImage2D(GL_TEXTURE_2D, 1, 0, 0, this->_sizeS*2, this->_sizeT*2, GL_RGBA, GL_TEXTURE_SRC_FORMAT, this->_upscaleBuffer);
 				
 				glTexSubImage2D(GL_TEXTURE_2D, 2, 0, 0, this->_sizeS*1, this->_sizeT*1, GL_RGBA, GL_TEXTURE_SRC_FORMAT, textureSrc);
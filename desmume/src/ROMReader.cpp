@@ -21,6 +21,11 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <stdio.h>
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
 #ifdef HAVE_LIBZZIP
 #include <zzip/zzip.h>
 #endif
@@ -49,7 +54,11 @@ ROMReader_struct * ROMReaderInit(char ** filename)
 		return &ZIPROMReader;
 	}
 #endif
+#ifndef WIN32
+	return &MMAPROMReader;
+#else
 	return &STDROMReader;
+#endif
 }
 
 void * STDROMReaderInit(const char * filename);
@@ -150,6 +159,135 @@ int STDROMReaderWrite(void *, void *, u32)
 	return 0;
 }
 
+#ifndef WIN32
+//maps the file read-only instead of reading it, so every process with the same ROM open
+//shares its pages in the page cache, and the data can be accessed in place.
+//files that can't be mapped (like empty ones) are left to the standard reader.
+void * MMAPROMReaderInit(const char * filename);
+void MMAPROMReaderDeInit(void *);
+u32 MMAPROMReaderSize(void *);
+int MMAPROMReaderSeek(void *, int, int);
+int MMAPROMReaderRead(void *, void *, u32);
+int MMAPROMReaderWrite(void *, void *, u32);
+void * MMAPROMReaderData(void *);
+
+ROMReader_struct MMAPROMReader =
+{
+	ROMREADER_MMAP,
+	"Mapped ROM Reader",
+	MMAPROMReaderInit,
+	MMAPROMReaderDeInit,
+	MMAPROMReaderSize,
+	MMAPROMReaderSeek,
+	MMAPROMReaderRead,
+	MMAPROMReaderWrite,
+	MMAPROMReaderData
+};
+
+struct MMAPROMReaderMapping
+{
+	u8 *data;
+	u32 size;
+	long pos;
+	void *std; //used instead of the mapping when that failed
+};
+
+void * MMAPROMReaderInit(const char * filename)
+{
+	void *std = STDROMReaderInit(filename);
+	if (!std) return NULL;
+
+	MMAPROMReaderMapping *ret = new MMAPROMReaderMapping();
+	ret->data = NULL;
+	ret->size = 0;
+	ret->pos = 0;
+	ret->std = std;
+
+	const int fd = open(filename, O_RDONLY);
+	if (fd != -1)
+	{
+		struct stat sb;
+		if (fstat(fd, &sb) == 0 && sb.st_size > 0 && (u64)sb.st_size <= 0xFFFFFFFF)
+		{
+			void *data = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+			if (data != MAP_FAILED)
+			{
+				ret->data = (u8 *)data;
+				ret->size = (u32)sb.st_size;
+			}
+		}
+		close(fd); //the mapping stays valid without the descriptor
+	}
+
+	if (ret->data)
+	{
+		STDROMReaderDeInit(ret->std);
+		ret->std = NULL;
+	}
+
+	return (void*)ret;
+}
+
+void MMAPROMReaderDeInit(void * file)
+{
+	if (!file) return;
+	MMAPROMReaderMapping *rd = (MMAPROMReaderMapping*)file;
+	if (rd->data)
+		munmap(rd->data, rd->size);
+	else
+		STDROMReaderDeInit(rd->std);
+	delete rd;
+}
+
+u32 MMAPROMReaderSize(void * file)
+{
+	if (!file) return 0;
+	MMAPROMReaderMapping *rd = (MMAPROMReaderMapping*)file;
+	if (!rd->data) return STDROMReaderSize(rd->std);
+	return rd->size;
+}
+
+int MMAPROMReaderSeek(void * file, int offset, int whence)
+{
+	if (!file) return 0;
+	MMAPROMReaderMapping *rd = (MMAPROMReaderMapping*)file;
+	if (!rd->data) return STDROMReaderSeek(rd->std, offset, whence);
+
+	switch(whence) {
+	case SEEK_SET: rd->pos = offset; break;
+	case SEEK_CUR: rd->pos += offset; break;
+	case SEEK_END: rd->pos = (long)rd->size + offset; break;
+	}
+	return 1;
+}
+
+int MMAPROMReaderRead(void * file, void * buffer, u32 size)
+{
+	if (!file) return 0;
+	MMAPROMReaderMapping *rd = (MMAPROMReaderMapping*)file;
+	if (!rd->data) return STDROMReaderRead(rd->std, buffer, size);
+
+	if (rd->pos < 0 || rd->pos >= (long)rd->size) return 0;
+	u32 todo = rd->size - (u32)rd->pos;
+	if (size < todo) todo = size;
+	memcpy(buffer, rd->data + rd->pos, todo);
+	rd->pos += todo;
+	return (int)todo;
+}
+
+int MMAPROMReaderWrite(void *, void *, u32)
+{
+	//the mapping is read-only
+	return 0;
+}
+
+void * MMAPROMReaderData(void * file)
+{
+	if (!file) return NULL;
+	return ((MMAPROMReaderMapping*)file)->data;
+}
+#endif
+
 #ifdef HAVE_LIBZ
 void * GZIPROMReaderInit(const char * filename);
 void GZIPROMReaderDeInit(void *);
@@ -339,6 +477,11 @@ int MemROMReaderRead(void * file, void * buffer, u32 size)
 	return todo;
 }
 
+void * MemROMReaderData(void *)
+{
+	return mem.buf;
+}
+
 int MemROMReaderWrite(void * file, void * buffer, u32 size)
 {
 	if(mem.pos<0) return 0;
@@ -364,6 +507,7 @@ static ROMReader_struct MemROMReader =
 	MemROMReaderSeek,
 	MemROMReaderRead,
 	MemROMReaderWrite,
+	MemROMReaderData,
 };
 
 ROMReader_struct * MemROMReaderRead_TrueInit(void* buf, int length)
@@ -31,6 +31,7 @@
 #define ROMREADER_GZIP	1
 #define ROMREADER_ZIP	2
 #define ROMREADER_MEM	3
+#define ROMREADER_MMAP	4
 
 typedef struct
 {
@@ -42,9 +43,14 @@ typedef struct
 	int (*Seek)(void * file, int offset, int whence);
 	int (*Read)(void * file, void * buffer, u32 size);
 	int (*Write)(void * file, void * buffer, u32 size);
+	//returns the whole file as one read-only buffer, for readers that hold it in memory (may be NULL)
+	void * (*Data)(void * file);
 } ROMReader_struct;
 
 extern ROMReader_struct STDROMReader;
+#ifndef WIN32
+extern ROMReader_struct MMAPROMReader;
+#endif
 #ifdef HAVE_LIBZ
 extern ROMReader_struct GZIPROMReader;
 #endif
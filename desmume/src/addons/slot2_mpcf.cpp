@@ -25,6 +25,7 @@
 
 #include "../slot2.h"
 #include "../debug.h"
+#include "../NDSSystem.h"
 #include "../emufile.h"
 #include "../path.h"
 #include "../utils/vfat.h"
@@ -104,7 +105,7 @@ static BOOL cflash_init()
 
 		fileStartLBA = fileEndLBA = 0xFFFFFFFF;
 		VFAT vfat;
-		bool ret = vfat.build(sFlashPath.c_str(),16); //allocate 16MB extra for writing. this is probably enough for anyone, but maybe it should be configurable.
+		bool ret = vfat.build(sFlashPath.c_str(),16,CommonSettings.fatDirLazy); //allocate 16MB extra for writing. this is probably enough for anyone, but maybe it should be configurable.
 		//we could always suggest to users to add a big file to their directory to overwrite (that would cause the image to get padded)
 
 		if(!ret)
@@ -86,6 +86,7 @@ using namespace AsmJit;
 #endif
 
 u32 saveBlockSizeJIT = 0;
+JIT_link_struct JIT_LINK[2];
 
 #ifdef MAPPED_JIT_FUNCS
 CACHE_ALIGN JIT_struct JIT;
@@ -191,6 +192,9 @@ static void init_jit_mem()
 	for(int proc=0; proc<2; proc++)
 		for(int i=0; i<0x4000; i++)
 			JIT.JIT_MEM[proc][i] = JIT_MEM[proc][i>>9] + (((i<<14) & JIT_MASK[proc][i>>9]) >> 1);
+
+	//the shared WRAM pages of the software TLB point into these
+	MMU_TLBRebuild();
 }
 
 #else
@@ -199,6 +203,20 @@ DS_ALIGN(4096) uintptr_t compiled_funcs[1<<26] = {0};
 
 static u8 recompile_counts[(1<<26)/16];
 
+// tiered compilation (CommonSettings.jit_tiered): a block is interpreted until its
+// start has been dispatched JIT_TIER_WARM times, then compiled as usual, and compiled
+// again as a superblock once the warm block has run JIT_TIER_HOT times.
+// Blocks whose starts collide in this table just get promoted a bit early.
+#define JIT_TIER_WARM 8
+#define JIT_TIER_HOT 1024
+#define JIT_HEAT_BITS 16
+static u16 jit_heat[2][1<<JIT_HEAT_BITS];
+#define JIT_HEAT(adr, PROCNUM) jit_heat[PROCNUM][((adr) >> 1) & ((1<<JIT_HEAT_BITS)-1)]
+
+// hot blocks may be this many times longer, and continue through this many unconditional branches
+#define JIT_HOT_BLOCK_SCALE 4
+#define JIT_HOT_MAX_BRANCHES 4
+
 #ifdef HAVE_STATIC_CODE_BUFFER
 // On x86_64, allocate jitted code from a static buffer to ensure that it's within 2GB of .text
 // Allows call instructions to use pcrel offsets, as opposed to slower indirect calls.
@@ -266,6 +284,16 @@ static GpVar bb_cpu;
 static GpVar bb_cycles;
 static GpVar bb_total_cycles;
 static u32 bb_constant_cycles;
+static u32 bb_flags_dead;
+
+// the CPSR flags, shifted down from bits 28-31
+#define FLAG_V 1
+#define FLAG_C 2
+#define FLAG_Z 4
+#define FLAG_N 8
+#define FLAGS_NZCV 0xF
+// no later instruction of the block reads these before writing them again, so they needn't be stored
+#define FLAGS_DEAD(x) ((bb_flags_dead & (x)) == (x))
 
 #define cpu (&ARMPROC)
 #define bb_next_instruction (bb_adr + bb_opcodesize)
@@ -335,7 +363,7 @@ static GpVar bb_profiler_entry;
 //-----------------------------------------------------------------------------
 //   Shifting macros
 //-----------------------------------------------------------------------------
-#define SET_NZCV(sign) { \
+#define SET_NZCV(sign) if(!FLAGS_DEAD(FLAGS_NZCV)) { \
 	JIT_COMMENT("SET_NZCV"); \
 	GpVar x = c.newGpVar(kX86VarTypeGpd); \
 	GpVar y = c.newGpVar(kX86VarTypeGpd); \
@@ -356,7 +384,7 @@ static GpVar bb_profiler_entry;
 	JIT_COMMENT("end SET_NZCV"); \
 }
 
-#define SET_NZC { \
+#define SET_NZC if(!FLAGS_DEAD(FLAG_N | FLAG_Z | (cf_change ? FLAG_C : 0))) { \
 	JIT_COMMENT("SET_NZC"); \
 	GpVar x = c.newGpVar(kX86VarTypeGpd); \
 	GpVar y = c.newGpVar(kX86VarTypeGpd); \
@@ -372,7 +400,7 @@ static GpVar bb_profiler_entry;
 	JIT_COMMENT("end SET_NZC"); \
 }
 
-#define SET_NZC_SHIFTS_ZERO(cf) { \
+#define SET_NZC_SHIFTS_ZERO(cf) if(!FLAGS_DEAD(FLAG_N | FLAG_Z | ((cf) ? FLAG_C : 0))) { \
 	JIT_COMMENT("SET_NZC_SHIFTS_ZERO"); \
 	c.and_(flags_ptr, 0x1F); \
 	if(cf) \
@@ -386,7 +414,7 @@ static GpVar bb_profiler_entry;
 	JIT_COMMENT("end SET_NZC_SHIFTS_ZERO"); \
 }
 
-#define SET_NZ(clear_cv) { \
+#define SET_NZ(clear_cv) if(!FLAGS_DEAD(FLAG_N | FLAG_Z | ((clear_cv) ? FLAG_C | FLAG_V : 0))) { \
 	JIT_COMMENT("SET_NZ"); \
 	GpVar x = c.newGpVar(kX86VarTypeGpz); \
 	GpVar y = c.newGpVar(kX86VarTypeGpz); \
@@ -401,7 +429,7 @@ static GpVar bb_profiler_entry;
 	JIT_COMMENT("end SET_NZ"); \
 }
 
-#define SET_N { \
+#define SET_N if(!FLAGS_DEAD(FLAG_N)) { \
 	JIT_COMMENT("SET_N"); \
 	GpVar x = c.newGpVar(kX86VarTypeGpz); \
 	GpVar y = c.newGpVar(kX86VarTypeGpz); \
@@ -414,7 +442,7 @@ static GpVar bb_profiler_entry;
 	JIT_COMMENT("end SET_N"); \
 }
 
-#define SET_Z { \
+#define SET_Z if(!FLAGS_DEAD(FLAG_Z)) { \
 	JIT_COMMENT("SET_Z"); \
 	GpVar x = c.newGpVar(kX86VarTypeGpz); \
 	GpVar y = c.newGpVar(kX86VarTypeGpz); \
@@ -734,6 +762,159 @@ static void emit_MMU_aluMemCycles(int alu_cycles, GpVar mem_cycles, int populati
 		c.add(mem_cycles, alu_cycles);
 }
 
+// wait states of a data access by bank and size, as _MMU_accesstime() counts them without advanced timing
+static u8 mem_wait[2][3][16];
+
+template<int PROC, int SIZE>
+static void init_mem_wait()
+{
+	for(u32 bank = 0; bank < 16; bank++)
+		mem_wait[PROC][SIZE>>4][bank] = _MMU_accesstime<PROC,MMU_AT_DATA,SIZE,MMU_AD_READ,false>(bank << 24, true);
+}
+
+// the advanced timing setting the current blocks were compiled for (see arm_jit_sync_timing())
+static bool jit_advanced_timing;
+
+// loads and stores to the pages the software TLB maps (main RAM, the TCMs, WRAM and mapped VRAM) are done
+// in place. unmapped pages (IO, the slot-2 area, anything hooked) call the helper instead, and so does ARM9
+// main RAM under advanced timing, which goes through the cache emulation. either way bb_cycles ends up as
+// the helper would return it.
+static void emit_mem_access(void *helper, GpVar adr, GpVar data, bool store, int size, bool sign)
+{
+	const u32 ptr_shift = (sizeof(void*) == 8) ? 3 : 2;
+	Label __slow = c.newLabel();
+	Label __done = c.newLabel();
+	GpVar tmp = c.newGpVar(kX86VarTypeGpz);
+	GpVar page = c.newGpVar(kX86VarTypeGpz);
+	GpVar idx = c.newGpVar(kX86VarTypeGpz);
+	GpVar ofs = c.newGpVar(kX86VarTypeGpz);
+
+	c.mov(idx.r32(), adr);
+	c.shr(idx.r32(), MMU_TLB_PAGE_SHIFT);
+	c.mov(tmp, (uintptr_t)(store ? mmu_tlb_write[PROCNUM] : mmu_tlb_read[PROCNUM]));
+	c.mov(page, sysint_ptr(tmp, idx, ptr_shift));
+	c.test(page, page);
+	c.jz(__slow);
+
+	if(PROCNUM == ARMCPU_ARM9 && jit_advanced_timing)
+	{
+		// DTCM is patched over main RAM, and isn't cached
+		Label __notmain = c.newLabel();
+		c.mov(ofs.r32(), adr);
+		c.and_(ofs.r32(), 0x0F000000);
+		c.cmp(ofs.r32(), 0x02000000);
+		c.jne(__notmain);
+#ifdef ACCOUNT_FOR_DATA_TCM_SPEED
+		c.mov(ofs.r32(), adr);
+		c.and_(ofs.r32(), ~0x3FFF);
+		c.mov(tmp, (uintptr_t)&MMU.DTCMRegion);
+		c.cmp(ofs.r32(), dword_ptr(tmp));
+		c.jne(__slow);
+#else
+		c.jmp(__slow);
+#endif
+		c.bind(__notmain);
+	}
+
+	c.mov(ofs.r32(), adr);
+	c.and_(ofs.r32(), MMU_TLB_PAGE_MASK & ~(size/8 - 1));
+	if(store)
+	{
+		if(size == 32) c.mov(dword_ptr(page, ofs), data);
+		else if(size == 16) c.mov(word_ptr(page, ofs), data.r16());
+		else c.mov(byte_ptr(page, ofs), data.r8Lo());
+
+		// same as MMU_TLBWrite(): drop the code compiled from here and, in main RAM, mark the snapshot page and bump its generation
+		Label __notmain = c.newLabel();
+		if(size == 8) c.and_(ofs.r32(), ~1);
+		c.mov(tmp, (uintptr_t)mmu_tlb_jit[PROCNUM]);
+		c.mov(page, sysint_ptr(tmp, idx, ptr_shift));
+		c.mov(sysint_ptr(page, ofs, ptr_shift - 1), 0);
+		if(size == 32) c.mov(sysint_ptr(page, ofs, ptr_shift - 1, sizeof(void*)), 0);
+		c.mov(ofs.r32(), adr);
+		c.and_(ofs.r32(), 0x0F000000);
+		c.cmp(ofs.r32(), 0x02000000);
+		c.jne(__notmain);
+		c.mov(tmp, (uintptr_t)&_MMU_MAIN_MEM_MASK);
+		c.mov(ofs.r32(), adr);
+		c.and_(ofs.r32(), dword_ptr(tmp));
+		c.shr(ofs.r32(), MMU_SNAPSHOT_PAGE_SHIFT);
+		c.and_(ofs.r32(), MMU_SNAPSHOT_MAIN_PAGES - 1);
+		c.mov(tmp, (uintptr_t)mmu_snapshot_main_dirty);
+		c.bts(dword_ptr(tmp), ofs.r32());
+		c.mov(tmp, (uintptr_t)mmu_main_write_gen);
+		c.inc(dword_ptr(tmp, ofs, 2));
+		c.bind(__notmain);
+	}
+	else
+	{
+		GpVar val = c.newGpVar(kX86VarTypeGpd);
+		if(size == 32) c.mov(val, dword_ptr(page, ofs));
+		else if(sign) c.movsx(val, (size == 16) ? word_ptr(page, ofs) : byte_ptr(page, ofs));
+		else c.movzx(val, (size == 16) ? word_ptr(page, ofs) : byte_ptr(page, ofs));
+		if(size == 32)
+		{
+			// unaligned words are rotated, as in OP_LDR()
+			GpVar rot = c.newGpVar(kX86VarTypeGpd);
+			c.mov(rot, adr);
+			c.and_(rot, 3);
+			c.shl(rot, 3);
+			c.ror(val, rot.r8Lo());
+		}
+		c.mov(dword_ptr(data), val);
+	}
+
+	// MMU_aluMemAccessCycles(), including the data fetch unit's idea of the last address
+	GpVar last = c.newGpVar(kX86VarTypeGpd);
+	c.mov(tmp, (uintptr_t)((PROCNUM == ARMCPU_ARM9) ? &MMU_timing.arm9dataFetch.lastAddress() : &MMU_timing.arm7dataFetch.lastAddress()));
+	c.mov(ofs.r32(), adr);
+	c.and_(ofs.r32(), ~(size/8 - 1));
+	if(jit_advanced_timing) c.mov(last, dword_ptr(tmp));
+	c.mov(dword_ptr(tmp), ofs.r32());
+	c.mov(idx.r32(), adr);
+	c.shr(idx.r32(), 24);
+	c.and_(idx.r32(), 0xF);
+	c.mov(tmp, (uintptr_t)mem_wait[PROCNUM][size>>4]);
+	c.movzx(bb_cycles, byte_ptr(tmp, idx));
+	if(jit_advanced_timing)
+	{
+		// the rest of _MMU_accesstime() with advanced timing, for the banks that aren't cached
+#ifdef ACCOUNT_FOR_NON_SEQUENTIAL_ACCESS
+		Label __sequential = c.newLabel();
+		c.add(last, size/8);
+		c.cmp(last, ofs.r32());
+		c.je(__sequential);
+		c.add(bb_cycles, (PROCNUM == ARMCPU_ARM9) ? 3*2 : 1);
+		c.bind(__sequential);
+#endif
+#ifdef ACCOUNT_FOR_DATA_TCM_SPEED
+		if(PROCNUM == ARMCPU_ARM9)
+		{
+			Label __notdtcm = c.newLabel();
+			c.and_(ofs.r32(), ~0x3FFF);
+			c.mov(tmp, (uintptr_t)&MMU.DTCMRegion);
+			c.cmp(ofs.r32(), dword_ptr(tmp));
+			c.jne(__notdtcm);
+			c.mov(bb_cycles, 1);
+			c.bind(__notdtcm);
+		}
+#endif
+	}
+	emit_MMU_aluMemCycles(store ? 2 : 3, bb_cycles, 0);
+	c.jmp(__done);
+
+	c.bind(__slow);
+	X86CompilerFuncCall *ctx = c.call(helper);
+	if(store)
+		ctx->setPrototype(ASMJIT_CALL_CONV, FuncBuilder2<u32, u32, u32>());
+	else
+		ctx->setPrototype(ASMJIT_CALL_CONV, FuncBuilder2<u32, u32, u32*>());
+	ctx->setArgument(0, adr);
+	ctx->setArgument(1, data);
+	ctx->setReturn(bb_cycles);
+	c.bind(__done);
+}
+
 //-----------------------------------------------------------------------------
 //   OPs
 //-----------------------------------------------------------------------------
@@ -1605,6 +1786,13 @@ static const OpLDR LDRB_tab[2][5]  = { T(OP_LDRB) };
 static const OpLDR LDRSB_tab[2][5]  = { T(OP_LDRSB) };
 #undef T
 
+// size and sign extension of each helper, for emit_mem_access()
+#define LDR_ACCESS   32, false
+#define LDRH_ACCESS  16, false
+#define LDRSH_ACCESS 16, true
+#define LDRB_ACCESS   8, false
+#define LDRSB_ACCESS  8, true
+
 static u32 add(u32 lhs, u32 rhs) { return lhs + rhs; }
 static u32 sub(u32 lhs, u32 rhs) { return lhs - rhs; }
 
@@ -1632,11 +1820,7 @@ static u32 sub(u32 lhs, u32 rhs) { return lhs - rhs; }
 		} \
 	} \
 	u32 adr_first = sign_op(cpu->R[REG_POS(i,16)], rhs_first); \
-	X86CompilerFuncCall *ctx = c.call((void*)mem_op##_tab[PROCNUM][classify_adr(adr_first,0)]); \
-	ctx->setPrototype(ASMJIT_CALL_CONV, FuncBuilder2<u32, u32, u32*>()); \
-	ctx->setArgument(0, adr); \
-	ctx->setArgument(1, dst); \
-	ctx->setReturn(bb_cycles); \
+	emit_mem_access((void*)mem_op##_tab[PROCNUM][classify_adr(adr_first,0)], adr, dst, false, mem_op##_ACCESS); \
 	if(REG_POS(i,12)==15) \
 	{ \
 		GpVar tmp = c.newGpVar(kX86VarTypeGpd); \
@@ -1800,6 +1984,10 @@ static const OpSTR STRH_tab[2][3]  = { T(OP_STRH) };
 static const OpSTR STRB_tab[2][3]  = { T(OP_STRB) };
 #undef T
 
+#define STR_ACCESS  32, false
+#define STRH_ACCESS 16, false
+#define STRB_ACCESS  8, false
+
 #define OP_STR_(mem_op, arg, sign_op, writeback) \
 	GpVar adr = c.newGpVar(kX86VarTypeGpd); \
 	GpVar data = c.newGpVar(kX86VarTypeGpd); \
@@ -1824,11 +2012,7 @@ static const OpSTR STRB_tab[2][3]  = { T(OP_STRB) };
 		} \
 	} \
 	u32 adr_first = sign_op(cpu->R[REG_POS(i,16)], rhs_first); \
-	X86CompilerFuncCall *ctx = c.call((void*)mem_op##_tab[PROCNUM][classify_adr(adr_first,1)]); \
-	ctx->setPrototype(ASMJIT_CALL_CONV, FuncBuilder2<u32, u32, u32>()); \
-	ctx->setArgument(0, adr); \
-	ctx->setArgument(1, data); \
-	ctx->setReturn(bb_cycles); \
+	emit_mem_access((void*)mem_op##_tab[PROCNUM][classify_adr(adr_first,1)], adr, data, true, mem_op##_ACCESS); \
 	return 1;
 
 static int OP_STR_P_IMM_OFF(const u32 i) { OP_STR_(STR, IMM_OFF_12, add, 0); }
@@ -2224,6 +2408,12 @@ static u32 FASTCALL OP_LDM_STM(u32 adr, u64 regs, int n)
 	{
 		ptr = MMU.MAIN_MEM + (adr & _MMU_MAIN_MEM_MASK32);
 		cycles = n * ((PROCNUM==ARMCPU_ARM9) ? 4 : 2);
+		if(store)
+		{
+			// the span can't cross a 16KB boundary (see above), so its ends cover every page it touches
+			MMU_MainMemMarkDirty(adr & _MMU_MAIN_MEM_MASK32);
+			MMU_MainMemMarkDirty((adr + (n-1)*4*dir) & _MMU_MAIN_MEM_MASK32);
+		}
 	}
 	else if(PROCNUM==ARMCPU_ARM7 && !store && (adr & 0xFF800000) == 0x03800000)
 	{
@@ -3527,11 +3717,7 @@ static int OP_TST(const u32 i)
 		adr_first += cpu->R[_REG_NUM(i, 6)]; \
 	} \
 	c.mov(data, reg_pos_thumb(0)); \
-	X86CompilerFuncCall *ctx = c.call((void*)mem_op##_tab[PROCNUM][classify_adr(adr_first,1)]); \
-	ctx->setPrototype(ASMJIT_CALL_CONV, FuncBuilder2<Void, u32, u32>()); \
-	ctx->setArgument(0, addr); \
-	ctx->setArgument(1, data); \
-	ctx->setReturn(bb_cycles); \
+	emit_mem_access((void*)mem_op##_tab[PROCNUM][classify_adr(adr_first,1)], addr, data, true, mem_op##_ACCESS); \
 	return 1;
 
 #define LDR_THUMB(mem_op, offset) \
@@ -3554,11 +3740,7 @@ static int OP_TST(const u32 i)
 		adr_first += cpu->R[_REG_NUM(i, 6)]; \
 	} \
 	c.lea(data, reg_pos_thumb(0)); \
-	X86CompilerFuncCall *ctx = c.call((void*)mem_op##_tab[PROCNUM][classify_adr(adr_first,0)]); \
-	ctx->setPrototype(ASMJIT_CALL_CONV, FuncBuilder2<Void, u32, u32*>()); \
-	ctx->setArgument(0, addr); \
-	ctx->setArgument(1, data); \
-	ctx->setReturn(bb_cycles); \
+	emit_mem_access((void*)mem_op##_tab[PROCNUM][classify_adr(adr_first,0)], addr, data, false, mem_op##_ACCESS); \
 	return 1;
 
 static int OP_STRB_IMM_OFF(const u32 i) { STR_THUMB(STRB, ((i>>6)&0x1F)); }
@@ -3588,11 +3770,7 @@ static int OP_STR_SPREL(const u32 i)
 	if (imm) c.add(addr, imm);
 	GpVar data = c.newGpVar(kX86VarTypeGpd);
 	c.mov(data, reg_pos_thumb(8));
-	X86CompilerFuncCall *ctx = c.call((void*)STR_tab[PROCNUM][classify_adr(adr_first,1)]);
-	ctx->setPrototype(ASMJIT_CALL_CONV, FuncBuilder2<Void, u32, u32>());
-	ctx->setArgument(0, addr);
-	ctx->setArgument(1, data);
-	ctx->setReturn(bb_cycles);
+	emit_mem_access((void*)STR_tab[PROCNUM][classify_adr(adr_first,1)], addr, data, true, STR_ACCESS);
 	return 1;
 }
 
@@ -3606,11 +3784,7 @@ static int OP_LDR_SPREL(const u32 i)
 	if (imm) c.add(addr, imm);
 	GpVar data = c.newGpVar(kX86VarTypeGpz);
 	c.lea(data, reg_pos_thumb(8));
-	X86CompilerFuncCall *ctx = c.call((void*)LDR_tab[PROCNUM][classify_adr(adr_first,0)]);
-	ctx->setPrototype(ASMJIT_CALL_CONV, FuncBuilder2<Void, u32, u32*>());
-	ctx->setArgument(0, addr);
-	ctx->setArgument(1, data);
-	ctx->setReturn(bb_cycles);
+	emit_mem_access((void*)LDR_tab[PROCNUM][classify_adr(adr_first,0)], addr, data, false, LDR_ACCESS);
 	return 1;
 }
 
@@ -3622,11 +3796,7 @@ static int OP_LDR_PCREL(const u32 i)
 	GpVar data = c.newGpVar(kX86VarTypeGpz);
 	c.mov(addr, adr_first);
 	c.lea(data, reg_pos_thumb(8));
-	X86CompilerFuncCall *ctx = c.call((void*)LDR_tab[PROCNUM][classify_adr(adr_first,0)]);
-	ctx->setPrototype(ASMJIT_CALL_CONV, FuncBuilder2<Void, u32, u32*>());
-	ctx->setArgument(0, addr);
-	ctx->setArgument(1, data);
-	ctx->setReturn(bb_cycles);
+	emit_mem_access((void*)LDR_tab[PROCNUM][classify_adr(adr_first,0)], addr, data, false, LDR_ACCESS);
 	return 1;
 }
 
@@ -3959,6 +4129,119 @@ static bool instr_does_prefetch(u32 opcode)
 			   && ((x & BRANCH_ALWAYS) || (x & BRANCH_LDM));
 }
 
+// the flags an instruction may read, and the ones it is sure to overwrite when it executes.
+// anything not recognised here is assumed to read all of them and overwrite none
+static void instr_flags(u32 opcode, u32 &read, u32 &written)
+{
+	read = FLAGS_NZCV;
+	written = 0;
+
+	if(bb_thumb)
+	{
+		if((opcode >> 13) == 0)				// LSL/LSR/ASR imm, ADD/SUB
+			written = ((opcode >> 11) == 3) ? FLAGS_NZCV : (FLAG_N | FLAG_Z);
+		else if((opcode >> 13) == 1)		// MOV/CMP/ADD/SUB imm8
+			written = (((opcode >> 11) & 3) == 0) ? (FLAG_N | FLAG_Z) : FLAGS_NZCV;
+		else if((opcode >> 10) == 0x10)		// ALU ops
+		{
+			switch((opcode >> 6) & 0xF)
+			{
+				case 0x5: case 0x6:			// ADC, SBC
+					read = FLAG_C;
+					written = FLAGS_NZCV;
+					return;
+				case 0x9: case 0xA: case 0xB: // NEG, CMP, CMN
+					written = FLAGS_NZCV;
+					break;
+				default:
+					written = FLAG_N | FLAG_Z;
+					break;
+			}
+		}
+		else if((opcode >> 10) == 0x11)		// hi register ADD/CMP/MOV
+		{
+			if(((opcode >> 8) & 3) == 3) return;
+			if(((opcode >> 8) & 3) == 1) written = FLAGS_NZCV;
+		}
+		else if((opcode >> 11) == 0x09 || (opcode >> 12) == 0x5 || (opcode >> 13) == 0x3 // loads and stores
+		     || (opcode >> 12) == 0x8 || (opcode >> 12) == 0x9 || (opcode >> 12) == 0xA
+		     || (opcode >> 8) == 0xB0 || (opcode & 0xF600) == 0xB400 || (opcode >> 12) == 0xC)
+			;
+		else
+			return;
+		read = 0;
+		return;
+	}
+
+	if(CONDITION(opcode) != 0xE)
+		return;
+
+	if((opcode & 0x0E000090) == 0x00000090)		// multiplies, SWP, halfword and doubleword transfers
+	{
+		written = ((opcode & 0x0F0000F0) == 0x00000090 && BIT20(opcode)) ? (FLAG_N | FLAG_Z) : 0;
+		read = 0;
+	}
+	else if((opcode & 0x0C000000) == 0)			// data processing
+	{
+		const u32 op = (opcode >> 21) & 0xF;
+		if((op & 0xC) == 0x8 && !BIT20(opcode))	// MRS, MSR, BX, CLZ, QADD...
+			return;
+		if(BIT20(opcode) && REG_POS(opcode,12) == 15)
+			return;
+		read = 0;
+		if(op >= 0x5 && op <= 0x7)				// ADC, SBC, RSC
+			read |= FLAG_C;
+		if(!BIT25(opcode) && (opcode & 0xFF0) == 0x060)	// RRX
+			read |= FLAG_C;
+		if(BIT20(opcode))
+			written = (op <= 0x1 || op == 0x8 || op == 0x9 || op >= 0xC) ? (FLAG_N | FLAG_Z) : FLAGS_NZCV;
+	}
+	else if((opcode & 0x0C000000) == 0x04000000)	// LDR/STR
+	{
+		if(!(BIT25(opcode) && BIT4(opcode)))
+			read = 0;
+		if(BIT25(opcode) && (opcode & 0xFF0) == 0x060)	// scaled register offset with RRX
+			read = FLAG_C;
+	}
+	else if((opcode & 0x0E000000) == 0x08000000)	// LDM/STM
+		read = 0;
+}
+
+// marks the flag writes nothing in the block reads before they are overwritten.
+// flags are live at the end of the block, and past the instructions scanned.
+// only the flags are tracked: guest registers stay in armcpu_t across the block, since every emitter
+// addresses them through reg_ptr() and the memory, LDM/STM and interpreter helpers use the cpu struct
+#define FLAGS_SCAN_MAX 128
+static u32 bb_flags_opcode[FLAGS_SCAN_MAX];
+static u8 bb_flags_dead_tab[FLAGS_SCAN_MAX];
+static u32 bb_flags_scanned;
+
+template<int PROCNUM>
+static void scan_flags(u32 start_adr, u32 max_size)
+{
+	u32 read[FLAGS_SCAN_MAX], written[FLAGS_SCAN_MAX];
+	u32 n = 0;
+
+	while(n < FLAGS_SCAN_MAX)
+	{
+		const u32 adr = start_adr + (n * bb_opcodesize);
+		const u32 opcode = bb_thumb ? _MMU_read16<PROCNUM, MMU_AT_CODE>(adr) : _MMU_read32<PROCNUM, MMU_AT_CODE>(adr);
+		bb_flags_opcode[n] = opcode;
+		instr_flags(opcode, read[n], written[n]);
+		n++;
+		if(instr_is_branch(opcode) || (n - 1 >= (max_size - 1)))
+			break;
+	}
+
+	u32 live = FLAGS_NZCV;
+	for(u32 i = n; i-- > 0; )
+	{
+		bb_flags_dead_tab[i] = written[i] & ~live;
+		live = (live & ~written[i]) | read[i];
+	}
+	bb_flags_scanned = n;
+}
+
 static const char *disassemble(u32 opcode)
 {
 	if(bb_thumb)
@@ -4035,6 +4318,131 @@ static void emit_branch(int cond, Label to)
 	}
 }
 
+// Returns the address a block ending with this opcode will most likely continue
+// at, if that address is known at compile time. Conditional branches return the
+// taken address; the emitted link compares against instruct_adr anyway.
+static bool instr_link_target(u32 opcode, u32 prev_opcode, bool has_prev, u32 *dst)
+{
+	if(!instr_is_branch(opcode))
+	{
+		*dst = bb_next_instruction;
+		return true;
+	}
+
+	if(bb_thumb)
+	{
+		// B
+		if((opcode & 0xF800) == 0xE000)
+		{
+			*dst = bb_r15 + (SIGNEXTEND_11(opcode)<<1);
+			return true;
+		}
+		// B<cond>, excluding SWI and the undefined condition
+		if((opcode & 0xF000) == 0xD000 && ((opcode>>8)&0xF) < 0xE)
+		{
+			*dst = bb_r15 + ((u32)((s8)(opcode&0xFF))<<1);
+			return true;
+		}
+		// second half of BL, with the first half in the same block
+		if((opcode & 0xF800) == 0xF800 && has_prev && (prev_opcode & 0xF800) == 0xF000)
+		{
+			*dst = bb_adr + 2 + (SIGNEXTEND_11(prev_opcode)<<12) + ((opcode&0x7FF)<<1);
+			return true;
+		}
+		return false;
+	}
+
+	// B and BL; BLX switches to THUMB and is left to the dispatcher
+	if((opcode & 0x0E000000) == 0x0A000000 && CONDITION(opcode) != 0xF)
+	{
+		*dst = bb_r15 + (SIGNEXTEND_24(opcode) << 2);
+		return true;
+	}
+	return false;
+}
+
+// Hot blocks don't end at unconditional direct branches but continue at the target, as long as it is
+// in the same JIT page as the block's start (see compile_basicblock()).
+// Only branches the JIT compiles itself are followed, so instruct_adr is always set.
+static bool instr_follow_target(u32 opcode, u32 prev_opcode, bool has_prev, u32 *dst)
+{
+	if(!instr_is_branch(opcode) || instr_is_conditional(opcode) || !instr_does_prefetch(opcode))
+		return false;
+	if(bb_thumb && (opcode & 0xF000) == 0xD000)
+		return false;
+	return instr_link_target(opcode, prev_opcode, has_prev, dst) && JIT_MAPPED(*dst & 0x0FFFFFFF, PROCNUM);
+}
+
+// idle loops found when their blocks were compiled. the compiled code points into this, so it is only
+// emptied by arm_jit_reset(); once it fills up, further loops are compiled without the check
+#define JIT_IDLE_LOOPS 4096
+static armcpu_idleLoop jit_idle_loops[JIT_IDLE_LOOPS];
+static u32 jit_idle_loop_count;
+
+// what is left of the link budget if the loop's loads all read plain memory right now, else 0
+template<int PROCNUM>
+static u32 FASTCALL idle_loop_skip(const armcpu_idleLoop *loop)
+{
+	if(!CommonSettings.skip_idle_loops || JIT_LINK[PROCNUM].budget <= 0)
+		return 0;
+	if(!armcpu_idleLoopReadsArePlain<PROCNUM>(*loop))
+		return 0;
+	return JIT_LINK[PROCNUM].budget;
+}
+
+static void emit_link(u32 dst, const armcpu_idleLoop *idle_loop)
+{
+	JIT_COMMENT("link to %08Xh", dst);
+	Label done = c.newLabel();
+	GpVar link = c.newGpVar(kX86VarTypeGpz);
+	GpVar f = c.newGpVar(kX86VarTypeGpz);
+
+	c.cmp(cpu_ptr(instruct_adr), dst);
+	c.jne(done);
+
+	if(idle_loop)
+	{
+		JIT_COMMENT("idle loop");
+		Label busy = c.newLabel();
+		GpVar loop = c.newGpVar(kX86VarTypeGpz);
+		GpVar skip = c.newGpVar(kX86VarTypeGpd);
+		c.mov(loop, (uintptr_t)idle_loop);
+		X86CompilerFuncCall* ctx = c.call((void*)(PROCNUM ? idle_loop_skip<1> : idle_loop_skip<0>));
+		ctx->setPrototype(ASMJIT_CALL_CONV, FuncBuilder1<u32, const armcpu_idleLoop*>());
+		ctx->setArgument(0, loop);
+		ctx->setReturn(skip);
+		c.cmp(skip, bb_total_cycles.r32());
+		c.jle(busy);
+		c.mov(bb_total_cycles.r32(), skip);
+		c.jmp(done);
+		c.bind(busy);
+	}
+	c.mov(link, (uintptr_t)&JIT_LINK[PROCNUM]);
+	c.sub(dword_ptr(link, offsetof(JIT_link_struct, budget)), bb_total_cycles.r32());
+	c.jle(done);
+	c.sub(dword_ptr(link, offsetof(JIT_link_struct, depth)), 1);
+	c.jl(done);
+	c.unuse(link);
+	c.cmp(cpu_ptr(freeze), 0);
+	c.jne(done);
+	c.mov(f, (uintptr_t)&nds.freezeBus);
+	c.cmp(dword_ptr(f), 0);
+	c.jne(done);
+
+	JIT_COMMENT("call linked block");
+	c.mov(f, (uintptr_t)&JIT_COMPILED_FUNC(dst, PROCNUM));
+	c.mov(f, sysint_ptr(f));
+	c.test(f, f);
+	c.jz(done);
+	GpVar cycles = c.newGpVar(kX86VarTypeGpz);
+	X86CompilerFuncCall* ctx = c.call(f);
+	ctx->setPrototype(ASMJIT_CALL_CONV, FuncBuilder0<u32>());
+	ctx->setReturn(cycles);
+	c.add(bb_total_cycles, cycles);
+	c.unuse(cycles);
+	c.bind(done);
+}
+
 static void emit_armop_call(u32 opcode)
 {
 	ArmOpCompiler fc = bb_thumb?	thumb_instruction_compilers[opcode>>6]:
@@ -4075,8 +4483,10 @@ static void _armlog(u8 proc, u32 addr, u32 opcode)
 #endif
 }
 
+template<int PROCNUM> static u32 FASTCALL arm_jit_promote();
+
 template<int PROCNUM>
-static u32 compile_basicblock()
+static u32 compile_basicblock(bool hot)
 {
 #if LOG_JIT
 	bool has_variable_cycles = FALSE;
@@ -4084,6 +4494,16 @@ static u32 compile_basicblock()
 	u32 interpreted_cycles = 0;
 	u32 start_adr = cpu->instruct_adr;
 	u32 opcode = 0;
+	u32 prev_opcode = 0;
+	u32 max_size = CommonSettings.jit_max_block_size;
+	if(hot)
+		max_size = std::min<u32>(max_size * JIT_HOT_BLOCK_SCALE, 100);
+
+	// the address ranges compiled so far, so that followed branches never loop back into the block
+	u32 seg_start[JIT_HOT_MAX_BRANCHES + 1];
+	u32 seg_end[JIT_HOT_MAX_BRANCHES + 1];
+	u32 followed = 0;
+	seg_start[0] = start_adr;
 	
 	bb_thumb = cpu->CPSR.bits.T;
 	bb_opcodesize = bb_thumb ? 2 : 4;
@@ -4108,6 +4528,24 @@ static u32 compile_basicblock()
 	bb_cpu = c.newGpVar(kX86VarTypeGpz);
 	c.mov(bb_cpu, (uintptr_t)&ARMPROC);
 
+	if(CommonSettings.jit_tiered && !hot)
+	{
+		JIT_COMMENT("count runs; once hot, have the next dispatch recompile the block");
+		Label warm = c.newLabel();
+		GpVar heat = c.newGpVar(kX86VarTypeGpz);
+		c.mov(heat, (uintptr_t)&JIT_HEAT(start_adr, PROCNUM));
+		c.add(word_ptr(heat), 1);
+		c.cmp(word_ptr(heat), JIT_TIER_HOT);
+		c.jb(warm);
+		GpVar promote = c.newGpVar(kX86VarTypeGpz);
+		c.mov(heat, (uintptr_t)&JIT_COMPILED_FUNC(start_adr, PROCNUM));
+		c.mov(promote, (uintptr_t)arm_jit_promote<PROCNUM>);
+		c.mov(sysint_ptr(heat), promote);
+		c.unuse(promote);
+		c.bind(warm);
+		c.unuse(heat);
+	}
+
 	JIT_COMMENT("reset bb_total_cycles");
 	bb_total_cycles = c.newGpVar(kX86VarTypeGpz);
 	c.mov(bb_total_cycles, 0);
@@ -4119,9 +4557,13 @@ static u32 compile_basicblock()
 #endif
 
 	bb_constant_cycles = 0;
+	scan_flags<PROCNUM>(start_adr, max_size);
+	u32 next_adr = start_adr;
 	for(u32 i=0, bEndBlock = 0; bEndBlock == 0; i++)
 	{
-		bb_adr = start_adr + (i * bb_opcodesize);
+		bb_adr = next_adr;
+		next_adr = bb_next_instruction;
+		prev_opcode = opcode;
 		if(bb_thumb)
 			opcode = _MMU_read16<PROCNUM, MMU_AT_CODE>(bb_adr);
 		else
@@ -4138,13 +4580,30 @@ static u32 compile_basicblock()
 
 		u32 cycles = instr_cycles(opcode);
 
-		bEndBlock = instr_is_branch(opcode) || (i >= (CommonSettings.jit_max_block_size - 1));
+		bEndBlock = instr_is_branch(opcode) || (i >= (max_size - 1));
+		if(hot && bEndBlock && i < (max_size - 1) && followed < JIT_HOT_MAX_BRANCHES
+		   && instr_follow_target(opcode, prev_opcode, ((u32)bb_adr != start_adr), &next_adr))
+		{
+			// a write only drops the code compiled at its own address, so a superblock stays within the
+			// 16KB JIT page of its start: code elsewhere (an overlay, say) could be replaced underneath it
+			seg_end[followed] = bb_adr;
+			bool skip = ((next_adr ^ start_adr) & ~0x3FFF) != 0;
+			for(u32 s = 0; s <= followed; s++)
+				skip |= (next_adr >= seg_start[s] && next_adr <= seg_end[s]);
+			if(!skip)
+			{
+				JIT_COMMENT("superblock: continue at %08Xh", next_adr);
+				seg_start[++followed] = next_adr;
+				bEndBlock = 0;
+			}
+		}
 		
 #if LOG_JIT
 		if (instr_is_conditional(opcode) && (cycles > 1) || (cycles == 0))
 			has_variable_cycles = TRUE;
 #endif
 		bb_cycles = c.newGpVar(kX86VarTypeGpz);
+		bb_flags_dead = (i < bb_flags_scanned && opcode == bb_flags_opcode[i]) ? bb_flags_dead_tab[i] : 0;
 
 		bb_constant_cycles += instr_is_conditional(opcode) ? 1 : cycles;
 
@@ -4219,6 +4678,20 @@ static u32 compile_basicblock()
 	profiler_entry[PROCNUM][padr].addr = start_adr;
 #endif
 
+	u32 link_adr = 0;
+	if(instr_link_target(opcode, prev_opcode, ((u32)bb_adr != start_adr), &link_adr) && JIT_MAPPED(link_adr & 0x0FFFFFFF, PROCNUM))
+	{
+		// a loop back to the block's own start may be waiting on memory
+		const armcpu_idleLoop *idle_loop = NULL;
+		if(link_adr == start_adr && !followed && CommonSettings.skip_idle_loops && jit_idle_loop_count < JIT_IDLE_LOOPS)
+		{
+			const u32 idle_count = (bb_adr - start_adr) / bb_opcodesize + 1;
+			if(armcpu_isIdleLoop<PROCNUM>(start_adr, idle_count, bb_thumb, jit_idle_loops[jit_idle_loop_count]))
+				idle_loop = &jit_idle_loops[jit_idle_loop_count++];
+		}
+		emit_link(link_adr, idle_loop);
+	}
+
 	c.ret(bb_total_cycles);
 #if LOG_JIT
 	fprintf(stderr, "cycles %d%s\n", bb_constant_cycles, has_variable_cycles ? " + variable" : "");
@@ -4241,13 +4714,48 @@ static u32 compile_basicblock()
 	return interpreted_cycles;
 }
 
+// runs a block in the interpreter, ending where compile_basicblock() would end it
+template<int PROCNUM>
+static u32 interpret_basicblock()
+{
+	u32 cycles = 0;
+	bb_thumb = cpu->CPSR.bits.T;
+	bb_opcodesize = bb_thumb ? 2 : 4;
+
+	for(u32 i=0; ; i++)
+	{
+		const u32 opcode = bb_thumb ? _MMU_read16<PROCNUM, MMU_AT_CODE>(cpu->instruct_adr)
+		                            : _MMU_read32<PROCNUM, MMU_AT_CODE>(cpu->instruct_adr);
+		cycles += op_decode[PROCNUM][bb_thumb]();
+		if(instr_is_branch(opcode) || (i >= (CommonSettings.jit_max_block_size - 1)))
+			break;
+	}
+	return cycles;
+}
+
+// what a warm block leaves in its slot once it is hot.
+// This isn't counted in recompile_counts, which is about code being overwritten.
+template<int PROCNUM>
+static u32 FASTCALL arm_jit_promote()
+{
+	*PROCNUM_ptr = PROCNUM;
+	return compile_basicblock<PROCNUM>(true);
+}
+
 template<int PROCNUM> u32 arm_jit_compile()
 {
 	*PROCNUM_ptr = PROCNUM;
 
+	// cold code is cheaper to interpret than to compile
+	u32 adr = cpu->instruct_adr;
+	if(CommonSettings.jit_tiered && JIT_MAPPED(adr & 0x0FFFFFFF, PROCNUM) && JIT_HEAT(adr, PROCNUM) < JIT_TIER_WARM)
+	{
+		JIT_HEAT(adr, PROCNUM)++;
+		return interpret_basicblock<PROCNUM>();
+	}
+
 	// prevent endless recompilation of self-modifying code, which would be a memleak since we only free code all at once.
 	// also allows us to clear compiled_funcs[] while leaving it sparsely allocated, if the OS does memory overcommit.
-	u32 adr = cpu->instruct_adr;
 	u32 mask_adr = (adr & 0x07FFFFFE) >> 4;
 	if(((recompile_counts[mask_adr >> 1] >> 4*(mask_adr & 1)) & 0xF) > 8)
 	{
@@ -4257,7 +4765,7 @@ template<int PROCNUM> u32 arm_jit_compile()
 	}
 	recompile_counts[mask_adr >> 1] += 1 << 4*(mask_adr & 1);
 
-	return compile_basicblock<PROCNUM>();
+	return compile_basicblock<PROCNUM>(CommonSettings.jit_tiered && JIT_HEAT(adr, PROCNUM) >= JIT_TIER_HOT);
 }
 
 template u32 arm_jit_compile<0>();
@@ -4278,7 +4786,18 @@ void arm_jit_reset(bool enable, bool suppress_msg)
 
 	if (enable)
 	{
-		printf("JIT: max block size %d instruction(s)\n", CommonSettings.jit_max_block_size);
+		if (!suppress_msg)
+			printf("JIT: max block size %d instruction(s)%s\n", CommonSettings.jit_max_block_size, CommonSettings.jit_tiered ? ", tiered" : "");
+
+		init_mem_wait<ARMCPU_ARM9,8>();
+		init_mem_wait<ARMCPU_ARM9,16>();
+		init_mem_wait<ARMCPU_ARM9,32>();
+		init_mem_wait<ARMCPU_ARM7,8>();
+		init_mem_wait<ARMCPU_ARM7,16>();
+		init_mem_wait<ARMCPU_ARM7,32>();
+		jit_advanced_timing = USE_TIMING();
+		jit_idle_loop_count = 0;
+		memset(jit_heat, 0, sizeof(jit_heat));
 
 #ifdef MAPPED_JIT_FUNCS
 
@@ -4322,6 +4841,36 @@ void arm_jit_reset(bool enable, bool suppress_msg)
 #endif
 }
 
+void arm_jit_sync_timing()
+{
+	if (USE_TIMING() != jit_advanced_timing)
+		arm_jit_reset(true, true);
+}
+
+#ifdef MAPPED_JIT_FUNCS
+void arm_jit_invalidate(const void *ptr, u32 len)
+{
+	const u8 *p = (const u8 *)ptr;
+	#define JITINVALIDATE(bank, mem) \
+		if (p >= mem && p < mem + ARRAY_SIZE(JIT.bank) * 2) \
+		{ \
+			const u32 ofs = (u32)(p - mem); \
+			memset(&JIT.bank[ofs >> 1], 0, (std::min<u32>(len, ARRAY_SIZE(JIT.bank) * 2 - ofs) >> 1) * sizeof(uintptr_t)); \
+		}
+		JITINVALIDATE(MAIN_MEM, MMU.MAIN_MEM);
+		JITINVALIDATE(SWIRAM, MMU.SWIRAM);
+		JITINVALIDATE(ARM9_ITCM, MMU.ARM9_ITCM);
+		JITINVALIDATE(ARM9_LCDC, MMU.ARM9_LCD);
+		JITINVALIDATE(ARM7_ERAM, MMU.ARM7_ERAM);
+		JITINVALIDATE(ARM7_WIRAM, MMU.ARM7_WIRAM);
+	#undef JITINVALIDATE
+
+	// the ARM7's view of VRAM is compiled per mapped address, which depends on the bank setup
+	if (p >= MMU.ARM9_LCD && p < MMU.ARM9_LCD + sizeof(MMU.ARM9_LCD))
+		memset(JIT.ARM7_WRAM, 0, sizeof(JIT.ARM7_WRAM));
+}
+#endif
+
 #if (PROFILER_JIT_LEVEL > 0)
 static int pcmp(PROFILER_COUNTER_INFO *info1, PROFILER_COUNTER_INFO *info2)
 {
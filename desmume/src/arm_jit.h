@@ -29,6 +29,8 @@ typedef u32 (FASTCALL* ArmOpCompiled)();
 void arm_jit_reset(bool enable, bool suppress_msg = false);
 void arm_jit_close();
 void arm_jit_sync();
+// resets the JIT if the advanced timing setting has changed since the current blocks were compiled
+void arm_jit_sync_timing();
 template<int PROCNUM> u32 arm_jit_compile();
 
 //#define MAPPED_JIT_FUNCS: to define or not to define?
@@ -67,6 +69,8 @@ extern CACHE_ALIGN JIT_struct JIT;
 #define JIT_COMPILED_FUNC_PREMASKED(adr, PROCNUM, ofs) JIT.JIT_MEM[PROCNUM][(adr)>>14][(((adr)&0x00003FFE)>>1)+ofs]
 #define JIT_COMPILED_FUNC_KNOWNBANK(adr, bank, mask, ofs) JIT.bank[(((adr)&(mask))>>1)+ofs]
 #define JIT_MAPPED(adr, PROCNUM) JIT.JIT_MEM[PROCNUM][(adr)>>14]
+// drops the code compiled from len bytes of emulated memory at the host pointer ptr
+void arm_jit_invalidate(const void *ptr, u32 len);
 #else
 // actually an array of function pointers, but they fit in 32bit address space, so might as well save memory
 extern uintptr_t compiled_funcs[];
@@ -79,4 +83,18 @@ extern uintptr_t compiled_funcs[];
 
 extern u32 saveBlockSizeJIT;
 
+// A block whose exit address is known at compile time calls straight into its
+// successor's compiled function, found through the successor's JIT_COMPILED_FUNC
+// slot. Zeroing that slot on a code write therefore also unlinks the block from
+// every predecessor. armcpu_exec() refills the budget (in CPU cycles) and the
+// depth before each dispatch; the depth bounds the host stack used by a chain.
+#define JIT_LINK_MAX_DEPTH 32
+
+struct JIT_link_struct
+{
+	s32 budget;
+	s32 depth;
+};
+extern JIT_link_struct JIT_LINK[2];
+
 #endif
@@ -391,10 +391,85 @@ u32 armcpu_Wait4IRQ(armcpu_t *cpu)
 	return 1;
 }
 
+//whether anything needs to see instruction fetches or executed instructions:
+//the read hooks, breakpoints and debug events of _MMU_read32<PROCNUM, MMU_AT_CODE>, or the exec hooks.
+//when nothing does, instructions can be fetched straight from host memory and the hook calls skipped.
+static FORCEINLINE bool armcpu_execHooked()
+{
+#ifdef GDB_STUB
+	return true;
+#else
+	if (CheckDebugEvent(DEBUG_EVENT_EXECUTE))
+		return true;
+	if (!memReadBreakPoints.empty())
+		return true;
+#ifdef HAVE_LUA
+	if (hookedRegions[LUAMEMHOOK_READ].NotEmpty() || hookedRegions[LUAMEMHOOK_EXEC].NotEmpty())
+		return true;
+#endif
+#ifdef TARGET_INTERFACE
+	if (hooked_regions[HOOK_READ].NotEmpty() || hooked_regions[HOOK_EXEC].NotEmpty())
+		return true;
+#endif
+	return false;
+#endif
+}
+
+//maps a code address to the host memory _MMU_read32<PROCNUM, MMU_AT_CODE> would read it from,
+//along with the number of bytes left before that mapping wraps.
+//returns NULL for anything which isn't plain memory (bios, shared wram, vram, slot-2...)
+template<int PROCNUM>
+static FORCEINLINE u8* armcpu_codeMap(const u32 adr, u32 &span)
+{
+	if ((adr & 0x0F000000) == 0x02000000)
+	{
+		const u32 ofs = adr & _MMU_MAIN_MEM_MASK;
+		span = _MMU_MAIN_MEM_MASK + 1 - ofs;
+		return MMU.MAIN_MEM + ofs;
+	}
+
+	if (PROCNUM == ARMCPU_ARM9 && adr < 0x02000000)
+	{
+		const u32 ofs = adr & 0x7FFF;
+		span = 0x8000 - ofs;
+		return MMU.ARM9_ITCM + ofs;
+	}
+
+	if (PROCNUM == ARMCPU_ARM7 && (adr & 0x0F800000) == 0x03800000)
+	{
+		const u32 ofs = adr & 0xFFFF;
+		span = 0x10000 - ofs;
+		return MMU.ARM7_ERAM + ofs;
+	}
+
+	return NULL;
+}
+
+//cycles taken by the fetch that armcpu_prefetch() just set up at curInstruction
 template<u32 PROCNUM>
+FORCEINLINE static u32 armcpu_prefetchCycles(const armcpu_t *armcpu, const u32 curInstruction)
+{
+	if(armcpu->CPSR.bits.T == 0)
+		return MMU_codeFetchCycles<PROCNUM,32>(curInstruction);
+
+	if(PROCNUM==0)
+	{
+		// arm9 fetches 2 instructions at a time in thumb mode
+		if(!(curInstruction == armcpu->instruct_adr + 2 && (curInstruction & 2)))
+			return MMU_codeFetchCycles<PROCNUM,32>(curInstruction);
+		else
+			return 0;
+	}
+
+	return MMU_codeFetchCycles<PROCNUM,16>(curInstruction);
+}
+
+template<u32 PROCNUM, bool HOOKS>
 FORCEINLINE static u32 armcpu_prefetch()
 {
 	armcpu_t* const armcpu = &ARMPROC;
+	u32 span;
+	u8 *code;
 //#ifdef GDB_STUB
 //	u32 temp_instruction;
 //#endif
@@ -420,10 +495,13 @@ FORCEINLINE static u32 armcpu_prefetch()
 		armcpu->instruct_adr = curInstruction;
 		armcpu->next_instruction = curInstruction + 4;
 		armcpu->R[15] = curInstruction + 8;
-		armcpu->instruction = _MMU_read32<PROCNUM, MMU_AT_CODE>(curInstruction);
+		if(!HOOKS && (code = armcpu_codeMap<PROCNUM>(curInstruction, span)) != NULL)
+			armcpu->instruction = T1ReadLong_guaranteedAligned(code, 0);
+		else
+			armcpu->instruction = _MMU_read32<PROCNUM, MMU_AT_CODE>(curInstruction);
 //#endif
 
-		return MMU_codeFetchCycles<PROCNUM,32>(curInstruction);
+		return armcpu_prefetchCycles<PROCNUM>(armcpu, curInstruction);
 	}
 
 //#ifdef GDB_STUB
@@ -444,19 +522,19 @@ FORCEINLINE static u32 armcpu_prefetch()
 	armcpu->instruct_adr = curInstruction;
 	armcpu->next_instruction = curInstruction + 2;
 	armcpu->R[15] = curInstruction + 4;
-	armcpu->instruction = _MMU_read16<PROCNUM, MMU_AT_CODE>(curInstruction);
+	if(!HOOKS && (code = armcpu_codeMap<PROCNUM>(curInstruction, span)) != NULL)
+		armcpu->instruction = T1ReadWord_guaranteedAligned(code, 0);
+	else
+		armcpu->instruction = _MMU_read16<PROCNUM, MMU_AT_CODE>(curInstruction);
 //#endif
 
-	if(PROCNUM==0)
-	{
-		// arm9 fetches 2 instructions at a time in thumb mode
-		if(!(curInstruction == armcpu->instruct_adr + 2 && (curInstruction & 2)))
-			return MMU_codeFetchCycles<PROCNUM,32>(curInstruction);
-		else
-			return 0;
-	}
+	return armcpu_prefetchCycles<PROCNUM>(armcpu, curInstruction);
+}
 
-	return MMU_codeFetchCycles<PROCNUM,16>(curInstruction);
+template<u32 PROCNUM>
+FORCEINLINE static u32 armcpu_prefetch()
+{
+	return armcpu_prefetch<PROCNUM,true>();
 }
 
 #if 0 /* not used */
@@ -599,8 +677,8 @@ u32 TRAPUNDEF(armcpu_t* cpu)
 //  return TRUE;
 //}
 
-template<int PROCNUM>
-u32 armcpu_exec()
+template<int PROCNUM, bool HOOKS>
+FORCEINLINE static u32 armcpu_execute()
 {
 	// Usually, fetching and executing are processed parallelly.
 	// So this function stores the cycles of each process to
@@ -677,12 +755,15 @@ u32 armcpu_exec()
 			|| (TEST_COND(CONDITION(ARMPROC.instruction), CODE(ARMPROC.instruction), ARMPROC.CPSR)) //handles any condition
 			)
 		{
+			if(HOOKS)
+			{
 #ifdef HAVE_LUA
-			CallRegisteredLuaMemHook(ARMPROC.instruct_adr, 4, ARMPROC.instruction, LUAMEMHOOK_EXEC); // should report even if condition=false?
+				CallRegisteredLuaMemHook(ARMPROC.instruct_adr, 4, ARMPROC.instruction, LUAMEMHOOK_EXEC); // should report even if condition=false?
 #endif
 #ifdef TARGET_INTERFACE
-            call_registered_interface_mem_hook(ARMPROC.instruct_adr, 4, HOOK_EXEC);
+				call_registered_interface_mem_hook(ARMPROC.instruct_adr, 4, HOOK_EXEC);
 #endif
+			}
 			#ifdef DEVELOPER
 			DEBUG_statistics.instructionHits[PROCNUM].arm[INSTRUCTION_INDEX(ARMPROC.instruction)]++;
 			#endif
@@ -697,16 +778,19 @@ u32 armcpu_exec()
 		}
 		ARMPROC.mem_if->prefetch32( ARMPROC.mem_if->data, ARMPROC.next_instruction);
 #endif
-		cFetch = armcpu_prefetch<PROCNUM>();
+		cFetch = armcpu_prefetch<PROCNUM,HOOKS>();
 		return MMU_fetchExecuteCycles<PROCNUM>(cExecute, cFetch);
 	}
 
+	if(HOOKS)
+	{
 #ifdef HAVE_LUA
-	CallRegisteredLuaMemHook(ARMPROC.instruct_adr, 2, ARMPROC.instruction, LUAMEMHOOK_EXEC);
+		CallRegisteredLuaMemHook(ARMPROC.instruct_adr, 2, ARMPROC.instruction, LUAMEMHOOK_EXEC);
 #endif
 #ifdef TARGET_INTERFACE
-    call_registered_interface_mem_hook(ARMPROC.instruct_adr, 2, HOOK_EXEC);
+		call_registered_interface_mem_hook(ARMPROC.instruct_adr, 2, HOOK_EXEC);
 #endif
+	}
 	#ifdef DEVELOPER
 	DEBUG_statistics.instructionHits[PROCNUM].thumb[ARMPROC.instruction>>6]++;
 	#endif
@@ -719,14 +803,461 @@ u32 armcpu_exec()
 	}
 	ARMPROC.mem_if->prefetch32( ARMPROC.mem_if->data, ARMPROC.next_instruction);
 #endif
-	cFetch = armcpu_prefetch<PROCNUM>();
+	cFetch = armcpu_prefetch<PROCNUM,HOOKS>();
 	return MMU_fetchExecuteCycles<PROCNUM>(cExecute, cFetch);
 }
 
+template<int PROCNUM>
+u32 armcpu_exec()
+{
+	//with nothing hooked, run the variant that leaves out every hook check
+	if(armcpu_execHooked())
+		return armcpu_execute<PROCNUM,true>();
+	else
+		return armcpu_execute<PROCNUM,false>();
+}
+
 //these templates needed to be instantiated manually
 template u32 armcpu_exec<0>();
 template u32 armcpu_exec<1>();
 
+//-------------
+//idle loops
+//-------------
+//A loop that only loads from memory, computes on what it loaded and branches back can't get anywhere
+//until an event or the other cpu changes that memory, so it may as well give up the rest of its time
+//slice. A register the loop reads has to be either left alone by the loop or set earlier in the same
+//pass, and the same goes for the flags; otherwise every pass differs from the last (a countdown, say).
+
+#define IDLE_LOOP_NONE 0xFF
+
+struct armcpu_idleOp
+{
+	u32 src, dst; //registers read and written
+	u8 flagsRead, flagsSet, flagsTouched; //NZCV as bits 3-0. flagsTouched may or may not change
+	bool load, word, absolute;
+	u8 base, index;
+	u32 offset; //the address itself when absolute
+};
+
+static const u8 armcpu_condFlags[16] = {
+	0x4, 0x4, 0x2, 0x2, 0x8, 0x8, 0x1, 0x1, 0x6, 0x6, 0x9, 0x9, 0xD, 0xD, 0x0, 0x0
+};
+
+static bool armcpu_idleLoad(armcpu_idleOp &op, u32 rd, u32 base, u32 index, u32 offset, bool word)
+{
+	if (rd == 15 || index == 15)
+		return false;
+	op.load = true;
+	op.word = word;
+	op.absolute = (base == 15);
+	op.base = op.absolute ? IDLE_LOOP_NONE : base;
+	op.index = (index == IDLE_LOOP_NONE) ? IDLE_LOOP_NONE : index;
+	op.offset = offset;
+	op.dst = 1 << rd;
+	op.src = (op.absolute ? 0 : (1 << base)) | ((index == IDLE_LOOP_NONE) ? 0 : (1 << index));
+	return true;
+}
+
+static bool armcpu_idleDecodeThumb(u32 adr, u32 i, armcpu_idleOp &op)
+{
+	const u32 rd = i & 7, rs = (i >> 3) & 7;
+
+	if ((i >> 13) == 0 && (i >> 11) != 3) //LSL/LSR/ASR imm
+	{
+		op.src = 1 << rs; op.dst = 1 << rd;
+		op.flagsSet = 0xC; op.flagsTouched = 0x2;
+	}
+	else if ((i >> 11) == 3) //ADD/SUB
+	{
+		op.src = (1 << rs) | (BIT10(i) ? 0 : (1 << ((i >> 6) & 7))); op.dst = 1 << rd;
+		op.flagsSet = 0xF;
+	}
+	else if ((i >> 13) == 1) //MOV/CMP/ADD/SUB imm8
+	{
+		const u32 rn = (i >> 8) & 7;
+		const u32 code = (i >> 11) & 3;
+		op.src = (code == 0) ? 0 : (1 << rn);
+		op.dst = (code == 1) ? 0 : (1 << rn);
+		op.flagsSet = (code == 0) ? 0xC : 0xF;
+	}
+	else if ((i >> 10) == 0x10) //ALU ops
+	{
+		const u32 code = (i >> 6) & 0xF;
+		const bool arith = (code == 0x5 || code == 0x6 || (code >= 0x9 && code <= 0xB));
+		op.src = (1 << rs) | ((code == 0x9 || code == 0xF) ? 0 : (1 << rd));
+		op.dst = (code == 0x8 || code == 0xA || code == 0xB) ? 0 : (1 << rd);
+		op.flagsRead = (code == 0x5 || code == 0x6) ? 0x2 : 0;
+		op.flagsSet = arith ? 0xF : 0xC;
+		op.flagsTouched = arith ? 0 : 0x3;
+	}
+	else if ((i >> 10) == 0x11) //hi register ADD/CMP/MOV
+	{
+		const u32 hd = (i & 7) | ((i >> 4) & 8), hs = (i >> 3) & 0xF;
+		const u32 code = (i >> 8) & 3;
+		if (code == 3 || hd == 15 || hs == 15)
+			return false;
+		op.src = (1 << hs) | ((code == 2) ? 0 : (1 << hd));
+		op.dst = (code == 1) ? 0 : (1 << hd);
+		op.flagsSet = (code == 1) ? 0xF : 0;
+	}
+	else if ((i >> 11) == 0x09) //LDR [PC, #imm]
+		return armcpu_idleLoad(op, (i >> 8) & 7, 15, IDLE_LOOP_NONE, ((adr + 4) & ~3) + ((i & 0xFF) << 2), true);
+	else if ((i >> 12) == 0x5) //LDR/LDRB/LDRH/LDRSB/LDRSH [Rb, Ro]
+	{
+		if (BIT9(i) ? !(BIT10(i) || BIT11(i)) : !BIT11(i)) //STR, STRB, STRH
+			return false;
+		return armcpu_idleLoad(op, rd, rs, (i >> 6) & 7, 0, !BIT9(i) && !BIT10(i));
+	}
+	else if ((i >> 13) == 0x3) //LDR/LDRB [Rb, #imm]
+	{
+		if (!BIT11(i))
+			return false;
+		return armcpu_idleLoad(op, rd, rs, IDLE_LOOP_NONE, ((i >> 6) & 0x1F) << (BIT12(i) ? 0 : 2), !BIT12(i));
+	}
+	else if ((i >> 12) == 0x8) //LDRH [Rb, #imm]
+	{
+		if (!BIT11(i))
+			return false;
+		return armcpu_idleLoad(op, rd, rs, IDLE_LOOP_NONE, ((i >> 6) & 0x1F) << 1, false);
+	}
+	else if ((i >> 12) == 0x9) //LDR [SP, #imm]
+	{
+		if (!BIT11(i))
+			return false;
+		return armcpu_idleLoad(op, (i >> 8) & 7, 13, IDLE_LOOP_NONE, (i & 0xFF) << 2, true);
+	}
+	else
+		return false;
+
+	return true;
+}
+
+static bool armcpu_idleDecodeArm(u32 adr, u32 i, armcpu_idleOp &op)
+{
+	if (CONDITION(i) != 0xE)
+		return false;
+
+	const u32 rn = REG_POS(i,16), rd = REG_POS(i,12);
+
+	if ((i & 0x0E000090) == 0x00000090) //LDRH/LDRSB/LDRSH [Rn, #imm], without writeback
+	{
+		if ((i & 0x00000060) == 0 || !BIT20(i) || !BIT22(i) || !BIT24(i) || BIT21(i))
+			return false;
+		const u32 imm = ((i >> 4) & 0xF0) | (i & 0xF);
+		const u32 offset = BIT23(i) ? imm : (u32)-(s32)imm;
+		return armcpu_idleLoad(op, rd, rn, IDLE_LOOP_NONE, (rn == 15) ? (adr + 8 + offset) : offset, false);
+	}
+
+	if ((i & 0x0C000000) == 0x04000000) //LDR/LDRB [Rn, #imm], without writeback
+	{
+		if (BIT25(i) || !BIT20(i) || !BIT24(i) || BIT21(i))
+			return false;
+		const u32 offset = BIT23(i) ? (i & 0xFFF) : (u32)-(s32)(i & 0xFFF);
+		return armcpu_idleLoad(op, rd, rn, IDLE_LOOP_NONE, (rn == 15) ? (adr + 8 + offset) : offset, !BIT22(i));
+	}
+
+	if ((i & 0x0C000000) != 0) //anything else that isn't data processing
+		return false;
+
+	const u32 code = (i >> 21) & 0xF;
+	if ((code & 0xC) == 0x8 && !BIT20(i)) //MRS, MSR, BX, CLZ, QADD...
+		return false;
+
+	op.src = ((code == 0xD || code == 0xF) ? 0 : (1 << rn))
+	       | (BIT25(i) ? 0 : (1 << REG_POS(i,0)))
+	       | ((!BIT25(i) && BIT4(i)) ? (1 << REG_POS(i,8)) : 0);
+	op.dst = ((code & 0xC) == 0x8) ? 0 : (1 << rd);
+	if ((op.src | op.dst) & (1 << 15))
+		return false;
+
+	if ((code >= 0x5 && code <= 0x7) || (!BIT25(i) && (i & 0xFF0) == 0x060)) //ADC, SBC, RSC, RRX
+		op.flagsRead = 0x2;
+	if (BIT20(i))
+	{
+		const bool logical = (code <= 0x1 || code == 0x8 || code == 0x9 || code >= 0xC);
+		op.flagsSet = logical ? 0xC : 0xF;
+		op.flagsTouched = logical ? 0x2 : 0;
+	}
+	return true;
+}
+
+//the rest of the loads go wherever their registers point now. reading the IPC FIFO, the gamecard data
+//port, the wifi registers or anything in the slot-2 area could change what is there, and the timer
+//counters keep running without any event to end the loop
+static bool armcpu_idleReadIsPlain(u32 adr)
+{
+	const u32 bank = (adr >> 24) & 0xF;
+	if (bank == 0x04)
+		return (adr & 0x00F00000) == 0 && (adr & 0x00FFFFF0) != 0x100;
+	return bank < 0x08;
+}
+
+template<int PROCNUM>
+bool armcpu_isIdleLoop(u32 adr, u32 count, bool thumb, armcpu_idleLoop &loop)
+{
+	loop.readCount = 0;
+	if (count < 1 || count > ARMCPU_IDLE_LOOP_MAX)
+		return false;
+
+	const u32 size = thumb ? 2 : 4;
+	armcpu_idleOp ops[ARMCPU_IDLE_LOOP_MAX];
+	u32 writtenAny = 0;
+	u8 flagsAny = 0;
+
+	for (u32 n = 0; n < count - 1; n++)
+	{
+		const u32 opAdr = adr + n * size;
+		armcpu_idleOp &op = ops[n];
+		memset(&op, 0, sizeof(op));
+		const bool ok = thumb
+			? armcpu_idleDecodeThumb(opAdr, _MMU_read16<PROCNUM,MMU_AT_CODE>(opAdr), op)
+			: armcpu_idleDecodeArm(opAdr, _MMU_read32<PROCNUM,MMU_AT_CODE>(opAdr), op);
+		if (!ok)
+			return false;
+		writtenAny |= op.dst;
+		flagsAny |= op.flagsSet | op.flagsTouched;
+	}
+
+	//the last opcode has to branch back to the first
+	const u32 brAdr = adr + (count - 1) * size;
+	u8 brFlags;
+	if (thumb)
+	{
+		const u32 i = _MMU_read16<PROCNUM,MMU_AT_CODE>(brAdr);
+		if ((i & 0xF000) == 0xD000 && ((i >> 8) & 0xF) < 0xE)
+		{
+			if (brAdr + 4 + ((u32)(s32)(s8)(i & 0xFF) << 1) != adr)
+				return false;
+			brFlags = armcpu_condFlags[(i >> 8) & 0xF];
+		}
+		else if ((i & 0xF800) == 0xE000)
+		{
+			if (brAdr + 4 + ((u32)(((s32)i << 21) >> 21) << 1) != adr)
+				return false;
+			brFlags = 0;
+		}
+		else
+			return false;
+	}
+	else
+	{
+		const u32 i = _MMU_read32<PROCNUM,MMU_AT_CODE>(brAdr);
+		if ((i & 0x0F000000) != 0x0A000000 || CONDITION(i) == 0xF)
+			return false;
+		if (brAdr + 8 + ((u32)(((s32)i << 8) >> 8) << 2) != adr)
+			return false;
+		brFlags = armcpu_condFlags[CONDITION(i)];
+	}
+
+	u32 defined = 0;
+	u8 flagsDefined = 0;
+	u32 literal[16] = {0}; //where a register set by an earlier PC-relative LDR got its value from
+
+	for (u32 n = 0; n < count - 1; n++)
+	{
+		const armcpu_idleOp &op = ops[n];
+		if (op.src & writtenAny & ~defined)
+			return false;
+		if (op.flagsRead & flagsAny & ~flagsDefined)
+			return false;
+
+		if (op.load)
+		{
+			if (loop.readCount == ARMCPU_IDLE_LOOP_READS)
+				return false;
+			armcpu_idleLoopRead &read = loop.read[loop.readCount++];
+			read.offset = op.offset;
+			read.literal = 0;
+			read.index = op.index;
+			read.base = op.base;
+			if (op.index != IDLE_LOOP_NONE && (defined & (1 << op.index)))
+				return false;
+			if (op.base != IDLE_LOOP_NONE && (defined & (1 << op.base)))
+			{
+				if (literal[op.base] == 0)
+					return false;
+				read.literal = literal[op.base];
+				read.base = IDLE_LOOP_NONE;
+			}
+		}
+
+		for (u32 r = 0; r < 16; r++)
+			if (op.dst & (1 << r))
+				literal[r] = (op.load && op.absolute && op.word) ? op.offset : 0;
+		defined |= op.dst;
+		flagsDefined |= op.flagsSet;
+	}
+
+	return !(brFlags & flagsAny & ~flagsDefined);
+}
+
+template<int PROCNUM>
+bool armcpu_idleLoopReadsArePlain(const armcpu_idleLoop &loop)
+{
+	const armcpu_t *armcpu = &ARMPROC;
+
+	for (u32 n = 0; n < loop.readCount; n++)
+	{
+		const armcpu_idleLoopRead &read = loop.read[n];
+		u32 loadAdr = read.offset;
+		if (read.index != IDLE_LOOP_NONE)
+			loadAdr += armcpu->R[read.index];
+		if (read.base != IDLE_LOOP_NONE)
+			loadAdr += armcpu->R[read.base];
+		if (read.literal != 0)
+			loadAdr += _MMU_read32<PROCNUM,MMU_AT_DEBUG>(read.literal);
+		if (!armcpu_idleReadIsPlain(loadAdr))
+			return false;
+	}
+	return true;
+}
+
+template bool armcpu_isIdleLoop<0>(u32 adr, u32 count, bool thumb, armcpu_idleLoop &loop);
+template bool armcpu_isIdleLoop<1>(u32 adr, u32 count, bool thumb, armcpu_idleLoop &loop);
+template bool armcpu_idleLoopReadsArePlain<0>(const armcpu_idleLoop &loop);
+template bool armcpu_idleLoopReadsArePlain<1>(const armcpu_idleLoop &loop);
+
+//-------------
+//cached interpreter
+//-------------
+//Straight-line runs of code are kept predecoded as the handler each opcode dispatches to, and are then
+//executed back to back without going through armInnerLoop() or the full _MMU_read path for every fetch.
+//A block in main RAM stays within one 4KB page and remembers the write generation the page had when it was
+//decoded (see mmu_main_write_gen), so it is validated once on entry: code that has been rewritten since (by
+//either cpu, DMA, cheats or a savestate load) simply gets decoded again. As with the JIT, a block that rewrites
+//its own later opcodes still runs them as decoded. Elsewhere (ITCM, ARM7 WRAM) nothing counts the writes, so
+//every fetched opcode is compared against the one its handler was decoded from instead.
+
+s32 armcpu_execBudget[2];
+
+struct armcpu_cachedBlock
+{
+	u32 key; //address of the first opcode, with bit 0 set for THUMB code
+	u32 count;
+	u32 idleCount; //how many opcodes the loop back to the start checked by armcpu_isIdleLoop() had, 0 if none
+	armcpu_idleLoop idleLoop;
+	u32 gen; //mmu_main_write_gen of the block's page when it was decoded, for blocks in main RAM
+	bool idle;
+	u32 opcode[ARMCPU_CACHED_BLOCK_SIZE];
+	OpFunc handler[ARMCPU_CACHED_BLOCK_SIZE];
+};
+
+static armcpu_cachedBlock armcpu_cachedBlocks[2][ARMCPU_CACHED_BLOCK_COUNT];
+
+template<int PROCNUM>
+u32 armcpu_execCached(s32 budget)
+{
+	armcpu_t* const armcpu = &ARMPROC;
+	const u32 thumb = armcpu->CPSR.bits.T;
+	const u32 adr = armcpu->instruct_adr;
+	u32 span;
+	u8 *code = armcpu_codeMap<PROCNUM>(adr, span);
+
+	if (code == NULL || armcpu_execHooked())
+		return armcpu_exec<PROCNUM>();
+
+	const u32 size = thumb ? 2 : 4;
+	u32 limit = std::min<u32>(ARMCPU_CACHED_BLOCK_SIZE, span / size);
+	const u32 freezeMask = (PROCNUM == ARMCPU_ARM9) ? CPU_FREEZE_WAIT_IRQ : (CPU_FREEZE_WAIT_IRQ | CPU_FREEZE_OVERCLOCK_HACK);
+
+	const u32 *gen = NULL;
+	if ((adr & 0x0F000000) == 0x02000000)
+	{
+		const u32 ofs = adr & _MMU_MAIN_MEM_MASK;
+		gen = &mmu_main_write_gen[ofs >> MMU_SNAPSHOT_PAGE_SHIFT];
+		limit = std::min<u32>(limit, ((1 << MMU_SNAPSHOT_PAGE_SHIFT) - (ofs & ((1 << MMU_SNAPSHOT_PAGE_SHIFT) - 1))) / size);
+	}
+
+	armcpu_cachedBlock &block = armcpu_cachedBlocks[PROCNUM][(adr >> (2 - thumb)) & (ARMCPU_CACHED_BLOCK_COUNT - 1)];
+	if (block.key != (adr | thumb) || (gen != NULL && block.gen != *gen))
+	{
+		block.key = adr | thumb;
+		block.count = 0;
+		block.idleCount = 0;
+		block.gen = (gen != NULL) ? *gen : 0;
+	}
+	const bool validated = (gen != NULL);
+
+	armcpu_execBudget[PROCNUM] = budget;
+	u32 cycles = 0;
+	u32 loopCount = 0;
+
+	for (u32 n = 0; ; n++)
+	{
+		const u32 opcode = armcpu->instruction;
+		OpFunc handler;
+		if (n < block.count && (validated || block.opcode[n] == opcode))
+			handler = block.handler[n];
+		else
+		{
+			handler = thumb ? thumb_instructions_set[PROCNUM][opcode>>6] : arm_instructions_set[PROCNUM][INSTRUCTION_INDEX(opcode)];
+			block.opcode[n] = opcode;
+			block.handler[n] = handler;
+			block.count = std::max(block.count, n + 1);
+			block.idleCount = 0;
+		}
+
+		u32 cExecute;
+		if (thumb)
+		{
+			#ifdef DEVELOPER
+			DEBUG_statistics.instructionHits[PROCNUM].thumb[opcode>>6]++;
+			#endif
+			cExecute = handler(opcode);
+		}
+		else if (CONDITION(opcode) == 0x0E || TEST_COND(CONDITION(opcode), CODE(opcode), armcpu->CPSR))
+		{
+			#ifdef DEVELOPER
+			DEBUG_statistics.instructionHits[PROCNUM].arm[INSTRUCTION_INDEX(opcode)]++;
+			#endif
+			cExecute = handler(opcode);
+		}
+		else
+			cExecute = 1; // If condition=false: 1S cycle
+
+		//keep fetching from the block only while execution falls through to its next opcode
+		const u32 curInstruction = adr + (n + 1) * size;
+		if (n + 1 >= limit || armcpu->next_instruction != curInstruction || armcpu->CPSR.bits.T != thumb)
+		{
+			cycles += MMU_fetchExecuteCycles<PROCNUM>(cExecute, armcpu_prefetch<PROCNUM>());
+			if (armcpu->instruct_adr == adr && armcpu->CPSR.bits.T == thumb)
+				loopCount = n + 1;
+			break;
+		}
+
+		armcpu->instruct_adr = curInstruction;
+		armcpu->next_instruction = curInstruction + size;
+		armcpu->R[15] = curInstruction + size * 2;
+		if (validated && n + 1 < block.count)
+			armcpu->instruction = block.opcode[n + 1];
+		else
+			armcpu->instruction = thumb ? T1ReadWord_guaranteedAligned(code, (n + 1) * 2) : T1ReadLong_guaranteedAligned(code, (n + 1) * 4);
+		cycles += MMU_fetchExecuteCycles<PROCNUM>(cExecute, armcpu_prefetchCycles<PROCNUM>(armcpu, curInstruction));
+
+		//stop wherever armInnerLoop() would have switched cpus or handled an event
+		if ((s32)cycles >= armcpu_execBudget[PROCNUM] || (armcpu->freeze & freezeMask) || nds.freezeBus || !execute)
+			break;
+	}
+
+	//a loop back to the start that only polls memory gives up what is left of the budget
+	if (loopCount != 0 && CommonSettings.skip_idle_loops && (s32)cycles < armcpu_execBudget[PROCNUM])
+	{
+		if (block.idleCount != loopCount)
+		{
+			block.idleCount = loopCount;
+			block.idle = armcpu_isIdleLoop<PROCNUM>(adr, loopCount, thumb != 0, block.idleLoop);
+		}
+		if (block.idle && armcpu_idleLoopReadsArePlain<PROCNUM>(block.idleLoop))
+			cycles = armcpu_execBudget[PROCNUM];
+	}
+
+	return cycles;
+}
+
+template u32 armcpu_execCached<0>(s32 budget);
+template u32 armcpu_execCached<1>(s32 budget);
+
 #ifdef HAVE_JIT
 void arm_jit_sync()
 {
@@ -737,22 +1268,27 @@ void arm_jit_sync()
 }
 
 template<int PROCNUM, bool jit>
-u32 armcpu_exec()
+u32 armcpu_exec(s32 linkBudget)
 {
 	if (jit)
 	{
 		ARMPROC.instruct_adr &= ARMPROC.CPSR.bits.T?0xFFFFFFFE:0xFFFFFFFC;
+		JIT_LINK[PROCNUM].budget = linkBudget;
+		JIT_LINK[PROCNUM].depth = JIT_LINK_MAX_DEPTH;
 		ArmOpCompiled f = (ArmOpCompiled)JIT_COMPILED_FUNC(ARMPROC.instruct_adr, PROCNUM);
 		return f ? f() : arm_jit_compile<PROCNUM>();
 	}
 
+	if (CommonSettings.use_cached_interpreter)
+		return armcpu_execCached<PROCNUM>(linkBudget);
+
 	return armcpu_exec<PROCNUM>();
 }
 
-template u32 armcpu_exec<0,false>();
-template u32 armcpu_exec<0,true>();
-template u32 armcpu_exec<1,false>();
-template u32 armcpu_exec<1,true>();
+template u32 armcpu_exec<0,false>(s32 linkBudget);
+template u32 armcpu_exec<0,true>(s32 linkBudget);
+template u32 armcpu_exec<1,false>(s32 linkBudget);
+template u32 armcpu_exec<1,true>(s32 linkBudget);
 #endif
 
 void setIF(int PROCNUM, u32 flag)
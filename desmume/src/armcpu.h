@@ -352,8 +352,37 @@ extern armcpu_t NDS_ARM9;
 extern const armcpu_ctrl_iface arm_default_ctrl_iface;
 
 template<int PROCNUM> u32 armcpu_exec();
+
+// Cached interpreter: keeps executing predecoded straight-line code for up to
+// budget cycles. NDS_Reschedule() zeroes armcpu_execBudget so that a pending
+// event stops the run at the next instruction boundary.
+#define ARMCPU_CACHED_BLOCK_SIZE 32
+#define ARMCPU_CACHED_BLOCK_COUNT 2048
+extern s32 armcpu_execBudget[2];
+template<int PROCNUM> u32 armcpu_execCached(s32 budget);
+
+// Idle loops: whether the count opcodes at adr, the last one branching back to adr, only poll
+// memory. loop receives where the loads read from, as an offset plus the current value of up to
+// two registers (0xFF for none) or the word at a literal address, so that whether those are plain
+// memory at the moment can be checked on every pass without decoding the loop again.
+#define ARMCPU_IDLE_LOOP_MAX 16
+#define ARMCPU_IDLE_LOOP_READS 4
+struct armcpu_idleLoopRead
+{
+	u32 offset;
+	u32 literal;
+	u8 base, index;
+};
+struct armcpu_idleLoop
+{
+	u32 readCount;
+	armcpu_idleLoopRead read[ARMCPU_IDLE_LOOP_READS];
+};
+template<int PROCNUM> bool armcpu_isIdleLoop(u32 adr, u32 count, bool thumb, armcpu_idleLoop &loop);
+template<int PROCNUM> bool armcpu_idleLoopReadsArePlain(const armcpu_idleLoop &loop);
+
 #ifdef HAVE_JIT
-template<int PROCNUM, bool jit> u32 armcpu_exec();
+template<int PROCNUM, bool jit> u32 armcpu_exec(s32 linkBudget);
 #endif
 
 void setIF(int PROCNUM, u32 flag);
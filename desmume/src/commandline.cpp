@@ -58,6 +58,9 @@ CommandLine::CommandLine()
 , _gamehacks(-1)
 , _texture_deposterize(-1)
 , _texture_smooth(-1)
+, _gpu_defer_line_render(-1)
+, _gpu_parallel_engines(-1)
+, _texture_cache_dir(NULL)
 , _slot1(NULL)
 , _slot1_fat_dir(NULL)
 , _slot1_fat_dir_type(false)
@@ -65,7 +68,13 @@ CommandLine::CommandLine()
 #ifdef HAVE_JIT
 , _cpu_mode(-1)
 , _jit_size(-1)
+, _jit_tiered(-1)
 #endif
+, _cached_interpreter(-1)
+, _skip_idle_loops(-1)
+, _savestate_compression(-1)
+, _backupmem_flush_interval(-1)
+, _fat_dir_lazy(0)
 , _console_type(NULL)
 , _advanscene_import(NULL)
 , load_slot(-1)
@@ -117,6 +126,17 @@ static const char* help_string = \
 "                            4:4x upscaling" ENDL
 " --3d-texture-smoothing-enable" ENDL
 "                            Enables smooth texture sampling while rendering." ENDL
+" --3d-texture-cache-dir PATH" ENDL
+"                            Keeps upscaled textures in this directory so that" ENDL
+"                            they can be reused in later sessions." ENDL
+" --gpu-defer-line-render    Render 2D lines on a worker thread; default OFF" ENDL
+" --gpu-parallel-engines     Render the main and sub 2D engines on separate" ENDL
+"                            threads; default OFF" ENDL
+" --savestate-compression N  Compression level for savestate files, 0-9;" ENDL
+"                            0:none, 1:fastest, 9:smallest; default 6" ENDL
+" --backupmem-flush-interval MS" ENDL
+"                            Longest time the save file may wait for changes" ENDL
+"                            to be written; 0:only when a write ends; default 1000" ENDL
 #ifdef HOST_WINDOWS
 " --gpu-resolution-multiplier N" ENDL
 "                            Increases the resolution of GPU rendering by this" ENDL
@@ -139,7 +159,12 @@ ENDL
 #ifdef HAVE_JIT
 " --jit-enable               Formerly --cpu-mode; default OFF" ENDL
 " --jit-size N               JIT block size 1-100; 1:accurate 100:fast (default)" ENDL
+" --jit-tiered               Interpret cold code and recompile hot blocks as" ENDL
+"                            larger superblocks; default OFF" ENDL
 #endif
+" --cached-interpreter       Run predecoded blocks when the JIT is off; default OFF" ENDL
+" --skip-idle-loops          Let loops that only poll memory skip ahead (JIT or" ENDL
+"                            cached interpreter); default OFF" ENDL
 " --advanced-timing          Use advanced bus-level timing; default ON" ENDL
 " --rigorous-timing          Use more realistic component timings; default OFF" ENDL
 " --gamehacks                Use game-specific hacks; default ON" ENDL
@@ -168,6 +193,8 @@ ENDL
 "Arguments affecting contents of SLOT-2:" ENDL
 " --cflash-image IMG_FILE    Mounts cflash in SLOT-2 with specified image file" ENDL
 " --cflash-path DIR          Mounts cflash in SLOT-2 with FS rooted at DIR" ENDL
+" --fat-dir-lazy             Leave files of --slot1-fat-dir and --cflash-path on" ENDL
+"                            disk and read them as the game asks for them" ENDL
 " --gbaslot-rom GBA_FILE     Mounts GBA specified rom in SLOT-2" ENDL
 ENDL
 "Commands taking place after ROM is loaded: (be sure to specify a ROM!)" ENDL
@@ -203,6 +230,9 @@ ENDL
 #define OPT_GPU_RESOLUTION_MULTIPLIER 82
 #define OPT_FRAMESKIP 83
 #define OPT_SCALE 84
+#define OPT_3D_TEXTURE_CACHE_DIR 85
+#define OPT_SAVESTATE_COMPRESSION 86
+#define OPT_BACKUPMEM_FLUSH_INTERVAL 87
 #define OPT_JIT_SIZE 100
 
 #define OPT_CONSOLE_TYPE 200
@@ -261,6 +291,11 @@ bool CommandLine::parse(int argc,char **argv)
 			{ "3d-texture-deposterize-enable", no_argument, &_texture_deposterize, 1 },
 			{ "3d-texture-upscale", required_argument, NULL, OPT_3D_TEXTURE_UPSCALE },
 			{ "3d-texture-smoothing-enable", no_argument, &_texture_smooth, 1 },
+			{ "3d-texture-cache-dir", required_argument, NULL, OPT_3D_TEXTURE_CACHE_DIR },
+			{ "gpu-defer-line-render", no_argument, &_gpu_defer_line_render, 1 },
+			{ "gpu-parallel-engines", no_argument, &_gpu_parallel_engines, 1 },
+			{ "savestate-compression", required_argument, NULL, OPT_SAVESTATE_COMPRESSION },
+			{ "backupmem-flush-interval", required_argument, NULL, OPT_BACKUPMEM_FLUSH_INTERVAL },
 			#ifdef HOST_WINDOWS
 				{ "gpu-resolution-multiplier", required_argument, NULL, OPT_GPU_RESOLUTION_MULTIPLIER },
 				{ "windowed-fullscreen", no_argument, &windowed_fullscreen, 1 },
@@ -279,7 +314,10 @@ bool CommandLine::parse(int argc,char **argv)
 			#ifdef HAVE_JIT
 				{ "jit-enable", no_argument, &_cpu_mode, 1},
 				{ "jit-size", required_argument, NULL, OPT_JIT_SIZE },
+				{ "jit-tiered", no_argument, &_jit_tiered, 1},
 			#endif
+			{ "cached-interpreter", no_argument, &_cached_interpreter, 1},
+			{ "skip-idle-loops", no_argument, &_skip_idle_loops, 1},
 			{ "rigorous-timing", no_argument, &_rigorous_timing, 1},
 			{ "advanced-timing", no_argument, &_advanced_timing, 1},
 			{ "gamehacks", no_argument, &_gamehacks, 1},
@@ -305,6 +343,7 @@ bool CommandLine::parse(int argc,char **argv)
 			//slot-2 contents
 			{ "cflash-image", required_argument, NULL, OPT_SLOT2_CFLASH_IMAGE},
 			{ "cflash-path", required_argument, NULL, OPT_SLOT2_CFLASH_DIR},
+			{ "fat-dir-lazy", no_argument, &_fat_dir_lazy, 1},
 			{ "gbaslot-rom", required_argument, NULL, OPT_SLOT2_GBAGAME},
 
 			//commands
@@ -345,6 +384,9 @@ bool CommandLine::parse(int argc,char **argv)
 		case OPT_SPU_METHOD: _spu_sync_method = atoi(optarg); break;
 		case OPT_3D_RENDER: _render3d = optarg; break;
 		case OPT_3D_TEXTURE_UPSCALE: texture_upscale = atoi(optarg); break;
+		case OPT_3D_TEXTURE_CACHE_DIR: _texture_cache_dir = strdup(optarg); break;
+		case OPT_SAVESTATE_COMPRESSION: _savestate_compression = atoi(optarg); break;
+		case OPT_BACKUPMEM_FLUSH_INTERVAL: _backupmem_flush_interval = atoi(optarg); break;
 		case OPT_GPU_RESOLUTION_MULTIPLIER: gpu_resolution_multiplier = atoi(optarg); break;
 		case OPT_SCALE: scale = atof(optarg); break;
 		case OPT_FRAMESKIP: frameskip = atoi(optarg); break;
@@ -403,6 +445,9 @@ bool CommandLine::parse(int argc,char **argv)
 
 	if(_load_to_memory != -1) CommonSettings.loadToMemory = (_load_to_memory == 1)?true:false;
 	if(_num_cores != -1) CommonSettings.num_cores = _num_cores;
+	if(_savestate_compression >= 0 && _savestate_compression <= 9) CommonSettings.savestate_compression = _savestate_compression;
+	if(_backupmem_flush_interval >= 0) CommonSettings.backupFlushInterval = _backupmem_flush_interval;
+	if(_fat_dir_lazy) CommonSettings.fatDirLazy = true;
 	if(_rigorous_timing) CommonSettings.rigorous_timing = true;
 	if(_advanced_timing != -1) CommonSettings.advanced_timing = _advanced_timing==1;
 	if(_gamehacks != -1) CommonSettings.gamehacks.en = _gamehacks==1;
@@ -416,7 +461,10 @@ bool CommandLine::parse(int argc,char **argv)
 		else
 			CommonSettings.jit_max_block_size = _jit_size;
 	}
+	if(_jit_tiered != -1) CommonSettings.jit_tiered = (_jit_tiered==1);
 #endif
+	if(_cached_interpreter != -1) CommonSettings.use_cached_interpreter = (_cached_interpreter==1);
+	if(_skip_idle_loops != -1) CommonSettings.skip_idle_loops = (_skip_idle_loops==1);
 
 	//process console type
 	CommonSettings.DebugConsole = false;
@@ -443,6 +491,9 @@ bool CommandLine::parse(int argc,char **argv)
 
 	if (_texture_deposterize != -1) CommonSettings.GFX3D_Renderer_TextureDeposterize = (_texture_deposterize == 1);
 	if (_texture_smooth != -1) CommonSettings.GFX3D_Renderer_TextureSmoothing = (_texture_smooth == 1);
+	if (_texture_cache_dir) { strncpy(CommonSettings.GFX3D_Renderer_TextureCachePath, _texture_cache_dir, MAX_PATH - 1); CommonSettings.GFX3D_Renderer_TextureCachePath[MAX_PATH - 1] = '\0'; }
+	if (_gpu_defer_line_render != -1) CommonSettings.GPU_DeferLineRender = (_gpu_defer_line_render == 1);
+	if (_gpu_parallel_engines != -1) CommonSettings.GPU_RenderEnginesInParallel = (_gpu_parallel_engines == 1);
 
 	if (autodetect_method != -1)
 		CommonSettings.autodetectBackupMethod = autodetect_method;
@@ -463,6 +514,8 @@ bool CommandLine::parse(int argc,char **argv)
 	free(_bios_arm9);
 	free(_bios_arm7);
 	_bios_arm9 = _bios_arm7 = NULL;
+	free(_texture_cache_dir);
+	_texture_cache_dir = NULL;
 
 	//remaining argument should be an NDS file, and nothing more
 	int remain = argc-optind;
@@ -106,10 +106,19 @@ private:
 	int _gamehacks;
 	int _texture_deposterize;
 	int _texture_smooth;
+	int _gpu_defer_line_render;
+	int _gpu_parallel_engines;
+	char* _texture_cache_dir;
 #ifdef HAVE_JIT
 	int _cpu_mode;
 	int _jit_size;
+	int _jit_tiered;
 #endif
+	int _cached_interpreter;
+	int _skip_idle_loops;
+	int _savestate_compression;
+	int _backupmem_flush_interval;
+	int _fat_dir_lazy;
 	char* _slot1;
 	char *_slot1_fat_dir;
 	char* _console_type;
@@ -476,6 +476,7 @@ BOOL armcp15_moveARM2CP(armcp15_t *armcp15, u32 val, u8 CRn, u8 CRm, u8 opcode1,
 				{
 				case 0:
 					MMU.DTCMRegion = armcp15->DTCMRegion = val & 0x0FFFF000;
+					MMU_TLBRebuild();
 					return TRUE;
 				case 1:
 					armcp15->ITCMRegion = val;
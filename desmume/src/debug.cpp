@@ -271,6 +271,7 @@ void DEBUG_reset()
 	//for now, just enable all debugging in developer builds
 #ifdef DEVELOPER
 	debugFlag = 1;
+	MMU_TLBSync();
 #endif
 
 	DEBUG_Notify = DebugNotify();
@@ -38,6 +38,7 @@
 #include <string>
 
 #define SCREENS_PIXEL_SIZE 98304
+#define MAIN_MEMORY_SIZE (4 * 1024 * 1024)
 volatile bool execute = false;
 TieredRegion hooked_regions [HOOK_COUNT];
 std::map<unsigned int, memory_cb_fnc> hooks[HOOK_COUNT];
@@ -135,6 +136,18 @@ EXPORTED void desmume_skip_next_frame()
     NDS_SkipNextFrame();
 }
 
+static void emulate_frame()
+{
+    NDS_beginProcessingInput();
+    {
+        FCEUMOV_AddInputState();
+    }
+    NDS_endProcessingInput();
+
+    NDS_exec<false>();
+    SPU_Emulate_user();
+}
+
 EXPORTED void desmume_cycle(BOOL with_joystick)
 {
     u16 keypad;
@@ -148,14 +161,7 @@ EXPORTED void desmume_cycle(BOOL with_joystick)
         update_keypad(keypad);
     }
 
-    NDS_beginProcessingInput();
-    {
-        FCEUMOV_AddInputState();
-    }
-    NDS_endProcessingInput();
-
-    NDS_exec<false>();
-    SPU_Emulate_user();
+    emulate_frame();
 }
 
 EXPORTED int desmume_sdl_get_ticks()
@@ -163,6 +169,85 @@ EXPORTED int desmume_sdl_get_ticks()
     return SDL_GetTicks();
 }
 
+EXPORTED void *desmume_instance_new(void)
+{
+    return NDS_CreateInstance();
+}
+
+EXPORTED void desmume_instance_free(void *instance)
+{
+    NDS_DestroyInstance((NDSInstance *)instance);
+}
+
+EXPORTED BOOL desmume_instance_select(void *instance)
+{
+    return NDS_SelectInstance((NDSInstance *)instance);
+}
+
+EXPORTED void *desmume_instance_current(void)
+{
+    return NDS_GetResidentInstance();
+}
+
+EXPORTED BOOL desmume_instance_acquire(void *instance)
+{
+    NDS_LockCore();
+    if (!NDS_SelectInstance((NDSInstance *)instance)) {
+        NDS_UnlockCore();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+EXPORTED void desmume_instance_release(void)
+{
+    NDS_UnlockCore();
+}
+
+EXPORTED size_t desmume_step_batch_output_size(int count, BOOL with_ram)
+{
+    size_t recordSize = SCREENS_PIXEL_SIZE * sizeof(u16);
+    if (with_ram)
+        recordSize += MAIN_MEMORY_SIZE;
+
+    return recordSize * count;
+}
+
+EXPORTED int desmume_step_batch(void **instances, int count, const u16 *inputs, int nframes, u8 *out, BOOL with_ram)
+{
+    const size_t recordSize = desmume_step_batch_output_size(1, with_ram);
+    int failed = 0;
+
+    NDS_LockCore();
+
+    // Instance-major, so that there is one instance switch per instance rather than one per frame.
+    for (int i = 0; i < count; i++) {
+        if (!NDS_SelectInstance((NDSInstance *)instances[i])) {
+            if (out != NULL)
+                memset(out + (recordSize * i), 0, recordSize);
+            failed++;
+            continue;
+        }
+
+        for (int f = 0; f < nframes; f++) {
+            if (inputs != NULL)
+                update_keypad(inputs[(i * nframes) + f]);
+            emulate_frame();
+        }
+
+        if (out != NULL) {
+            u8 *record = out + (recordSize * i);
+            memcpy(record, desmume_draw_raw(), SCREENS_PIXEL_SIZE * sizeof(u16));
+            if (with_ram)
+                memcpy(record + (SCREENS_PIXEL_SIZE * sizeof(u16)), MMU.MAIN_MEM, MAIN_MEMORY_SIZE);
+        }
+    }
+
+    NDS_UnlockCore();
+
+    return failed;
+}
+
 #ifdef INCLUDE_OPENGL_2D
 EXPORTED void desmume_draw_opengl(GLuint *texture)
 {
@@ -262,6 +347,12 @@ EXPORTED BOOL desmume_savestate_save(const char *file_name)
     return savestate_save(file_name);
 }
 
+EXPORTED void desmume_savestate_set_compression(int level)
+{
+    if (level >= 0 && level <= 9)
+        CommonSettings.savestate_compression = level;
+}
+
 EXPORTED void desmume_savestate_scan()
 {
     scan_savestates();
@@ -287,6 +378,51 @@ EXPORTED char* desmume_savestate_slot_date(int index)
     return savestates[index].date;
 }
 
+EXPORTED void *desmume_snapshot_create()
+{
+    return snapshot_create();
+}
+
+EXPORTED void desmume_snapshot_destroy(void *handle)
+{
+    snapshot_destroy((savestate_snapshot *)handle);
+}
+
+EXPORTED BOOL desmume_snapshot_take(void *handle)
+{
+    return snapshot_take((savestate_snapshot *)handle);
+}
+
+EXPORTED BOOL desmume_snapshot_take_incremental(void *handle, void *base)
+{
+    return snapshot_take_incremental((savestate_snapshot *)handle, (savestate_snapshot *)base);
+}
+
+EXPORTED BOOL desmume_snapshot_restore(void *handle)
+{
+    return snapshot_restore((savestate_snapshot *)handle);
+}
+
+EXPORTED void desmume_rewind_setup(int interval, int capacity)
+{
+    rewind_setup(interval, capacity);
+}
+
+EXPORTED void desmume_rewind_clear()
+{
+    rewind_clear();
+}
+
+EXPORTED int desmume_rewind_count()
+{
+    return rewind_count();
+}
+
+EXPORTED BOOL desmume_rewind_step(int frames)
+{
+    return rewind_step(frames);
+}
+
 EXPORTED BOOL desmume_gpu_get_layer_main_enable_state(int layer_index)
 {
     return GPU->GetEngineMain()->GetLayerEnableState(layer_index);
@@ -307,6 +443,16 @@ EXPORTED void desmume_gpu_set_layer_sub_enable_state(int layer_index, BOOL the_s
     GPU->GetEngineSub()->SetLayerEnableState(layer_index, the_state);
 }
 
+EXPORTED void desmume_gpu_set_defer_line_render(BOOL the_state)
+{
+    CommonSettings.GPU_DeferLineRender = (the_state != FALSE);
+}
+
+EXPORTED void desmume_gpu_set_render_engines_in_parallel(BOOL the_state)
+{
+    CommonSettings.GPU_RenderEnginesInParallel = (the_state != FALSE);
+}
+
 EXPORTED int desmume_volume_get()
 {
     return SNDSDLGetAudioVolume();
@@ -504,6 +650,7 @@ INLINE void memory_register_hook(int addr, MemHookType hook_type, int size, memo
         hooked_bytes.push_back(it->first);
     }
     hooked_regions[hook_type].Calculate(hooked_bytes);
+    MMU_TLBRebuild();
 }
 
 EXPORTED void desmume_memory_register_write(int address, int size, memory_cb_fnc cb)
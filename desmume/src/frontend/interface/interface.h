@@ -82,6 +82,39 @@ EXPORTED void desmume_cycle(BOOL with_joystick);
 
 EXPORTED int desmume_sdl_get_ticks();
 
+// Multiple emulators per process. Each instance is an independent console sharing the
+// loaded ROM, BIOS and firmware, with its own save file (the first instance uses the
+// ROM's .dsv, the others "<ROM name>.N.dsv"). There is still a single emulator core:
+// only the selected instance is emulated, and selecting another one swaps its state
+// into the core, so instances run one at a time even when hosted on several threads.
+// All other exports act on the selected instance. desmume_instance_new() clones the
+// state of the selected instance (or the current core state, if none is selected yet),
+// so load the ROM first. Threads hosting their own instances should bracket their
+// calls with desmume_instance_acquire() / desmume_instance_release().
+EXPORTED void *desmume_instance_new(void);
+EXPORTED void desmume_instance_free(void *instance);
+EXPORTED BOOL desmume_instance_select(void *instance);
+EXPORTED void *desmume_instance_current(void);
+EXPORTED BOOL desmume_instance_acquire(void *instance);
+EXPORTED void desmume_instance_release(void);
+
+// Advances several instances by nframes frames each in one call. This is a serial
+// convenience API: the instances share the one core, so they are stepped one after
+// the other on the calling thread, each through all of its nframes frames before the
+// next is selected. They are not run in parallel, nor interleaved frame by frame;
+// since instances never affect each other, the results are the same as if they were.
+// inputs holds the keypad state (as for desmume_input_keypad_update) for every instance
+// and frame, instance-major: inputs[i * nframes + f]. Pass NULL to keep the current input.
+// After stepping, the output of every instance is written to out, one record per
+// instance: the raw framebuffer (SCREENS_PIXEL_SIZE u16 values, as desmume_draw_raw)
+// followed by the 4MB main RAM if with_ram is set. Use desmume_step_batch_output_size()
+// to size out. The last instance that could be selected remains selected.
+// Switching to each instance takes a snapshot of the previous one and restores the
+// selected one's, once per instance per call, so prefer a larger nframes.
+// Returns the number of instances that could not be selected; their records are zeroed.
+EXPORTED size_t desmume_step_batch_output_size(int count, BOOL with_ram);
+EXPORTED int desmume_step_batch(void **instances, int count, const u16 *inputs, int nframes, u8 *out, BOOL with_ram);
+
 // Drawing is either supported manually via a custom OpenGL texture...
 #ifdef INCLUDE_OPENGL_2D
 EXPORTED void desmume_draw_opengl(GLuint *texture);
@@ -100,16 +133,38 @@ EXPORTED void desmume_draw_raw_as_rgbx(u8 *buffer);
 EXPORTED void desmume_savestate_clear();
 EXPORTED BOOL desmume_savestate_load(const char *file_name);
 EXPORTED BOOL desmume_savestate_save(const char *file_name);
+// zlib level (0-9) used by desmume_savestate_save; 1 is the fastest.
+EXPORTED void desmume_savestate_set_compression(int level);
 EXPORTED void desmume_savestate_scan();
 EXPORTED void desmume_savestate_slot_load(int index);
 EXPORTED void desmume_savestate_slot_save(int index);
 EXPORTED BOOL desmume_savestate_slot_exists(int index);
 EXPORTED char* desmume_savestate_slot_date(int index);
 
+// In-memory snapshots for cloning and restoring the emulator state many times over.
+// A snapshot can only be restored in the same session and with the same ROM it was taken with.
+EXPORTED void *desmume_snapshot_create();
+EXPORTED void desmume_snapshot_destroy(void *handle);
+EXPORTED BOOL desmume_snapshot_take(void *handle);
+// Only copies the memory pages written since base, which must be the full snapshot last taken or restored.
+EXPORTED BOOL desmume_snapshot_take_incremental(void *handle, void *base);
+EXPORTED BOOL desmume_snapshot_restore(void *handle);
+
+// Capture a rewind state every `interval` frames, keeping at most `capacity` of them (0 disables rewinding).
+EXPORTED void desmume_rewind_setup(int interval, int capacity);
+EXPORTED void desmume_rewind_clear();
+EXPORTED int desmume_rewind_count();
+// Go back to the newest rewind state from at least `frames` frames ago.
+EXPORTED BOOL desmume_rewind_step(int frames);
+
 EXPORTED BOOL desmume_gpu_get_layer_main_enable_state(int layer_index);
 EXPORTED BOOL desmume_gpu_get_layer_sub_enable_state(int layer_index);
 EXPORTED void desmume_gpu_set_layer_main_enable_state(int layer_index, BOOL the_state);
 EXPORTED void desmume_gpu_set_layer_sub_enable_state(int layer_index, BOOL the_state);
+// Moves 2D rendering onto worker threads; see GPUSubsystem::SetWillDeferLineRender() and
+// GPUSubsystem::SetWillRenderEnginesInParallel(). Takes effect at the start of the next frame.
+EXPORTED void desmume_gpu_set_defer_line_render(BOOL the_state);
+EXPORTED void desmume_gpu_set_render_engines_in_parallel(BOOL the_state);
 
 EXPORTED int desmume_volume_get();
 EXPORTED void desmume_volume_set(int volume);
@@ -238,6 +293,30 @@ struct TieredRegion
     Region<0x1000> mid;
     Region<0> narrow;
 
+    // one bit per 4KB page of the address space, set if any hooked byte lies in that page,
+    // so that an access to an unhooked page is rejected with a single bit test.
+    // left empty when nothing is hooked.
+    enum { PAGE_SHIFT = 12 };
+    std::vector<unsigned int> pages;
+
+    void CalculatePages(const std::vector<unsigned int>& bytes)
+    {
+        pages.clear();
+        if(bytes.empty())
+            return;
+
+        pages.resize(1u << (32 - PAGE_SHIFT - 5));
+        std::vector<unsigned int>::const_iterator iter = bytes.begin();
+        std::vector<unsigned int>::const_iterator end = bytes.end();
+        for(; iter != end; ++iter)
+            pages[*iter >> (PAGE_SHIFT + 5)] |= 1u << ((*iter >> PAGE_SHIFT) & 31);
+    }
+
+    FORCEINLINE bool PageHooked(unsigned int address) const
+    {
+        return (pages[address >> (PAGE_SHIFT + 5)] >> ((address >> PAGE_SHIFT) & 31)) & 1;
+    }
+
     void Calculate(std::vector<unsigned int>& bytes)
     {
         std::sort(bytes.begin(), bytes.end());
@@ -245,6 +324,7 @@ struct TieredRegion
         broad.Calculate(bytes);
         mid.Calculate(bytes);
         narrow.Calculate(bytes);
+        CalculatePages(bytes);
     }
 
     TieredRegion()
@@ -261,7 +341,7 @@ struct TieredRegion
     // note: it is illegal to call this if NotEmpty() returns 0
     FORCEINLINE bool Contains(unsigned int address, int size)
     {
-        return broad.islands[0].Contains(address,size) &&
+        return (PageHooked(address) || PageHooked(address+size-1)) &&
                mid.Contains(address,size) &&
                narrow.Contains(address,size);
     }
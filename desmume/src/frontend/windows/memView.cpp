@@ -29,6 +29,7 @@
 
 #include "resource.h"
 #include "winutil.h"
+#include "windriver.h"
 #include "version.h"
 
 using namespace std;
@@ -680,7 +681,12 @@ INT_PTR CALLBACK MemView_DlgProc(HWND hDlg, UINT uMsg, WPARAM wParam, LPARAM lPa
 		{
 			char str[16];
 			GetDlgItemText(hDlg, IDC_MEMBPTARG, str, 16);
-			memReadBreakPoints.push_back(strtol(str, NULL, 16));
+			{
+				//the memory fast paths only leave room for breakpoints once the TLB is rebuilt
+				Lock lock;
+				memReadBreakPoints.push_back(strtol(str, NULL, 16));
+				MMU_TLBSync();
+			}
 			wnd->Refresh();
 			wnd->SetFocus();
 			InvalidateRect(hDlg, NULL, FALSE);
@@ -690,7 +696,11 @@ INT_PTR CALLBACK MemView_DlgProc(HWND hDlg, UINT uMsg, WPARAM wParam, LPARAM lPa
 		{
 			char str[16];
 			GetDlgItemText(hDlg, IDC_MEMBPTARG, str, 16);
-			memWriteBreakPoints.push_back(strtol(str, NULL, 16));
+			{
+				Lock lock;
+				memWriteBreakPoints.push_back(strtol(str, NULL, 16));
+				MMU_TLBSync();
+			}
 			wnd->Refresh();
 			wnd->SetFocus();
 			InvalidateRect(hDlg, NULL, FALSE);
@@ -698,7 +708,9 @@ INT_PTR CALLBACK MemView_DlgProc(HWND hDlg, UINT uMsg, WPARAM wParam, LPARAM lPa
 		}
 		case IDC_DELREADBP: {
 			if (RBPOffs < memReadBreakPoints.size()) {
+				Lock lock;
 				memReadBreakPoints.erase(memReadBreakPoints.begin() + RBPOffs);
+				MMU_TLBSync();
 			}
 			wnd->Refresh();
 			wnd->SetFocus();
@@ -707,7 +719,9 @@ INT_PTR CALLBACK MemView_DlgProc(HWND hDlg, UINT uMsg, WPARAM wParam, LPARAM lPa
 		}
 		case IDC_DELWRITEBP: {
 			if (WBPOffs < memWriteBreakPoints.size()) {
+				Lock lock;
 				memWriteBreakPoints.erase(memWriteBreakPoints.begin() + WBPOffs);
+				MMU_TLBSync();
 			}
 			wnd->Refresh();
 			wnd->SetFocus();
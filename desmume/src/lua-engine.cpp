@@ -1890,6 +1890,7 @@ DEFINE_LUA_FUNCTION(vram_writeword, "address,value")
 	int address = luaL_checkinteger(L,1);
 	u16 value = (u16)(luaL_checkinteger(L,2) & 0xFFFF);
 	T1WriteWord(MMU.ARM9_LCD,address,value);
+	MMU_VRAMMarkDirtyRange(address,2);
 	return 0;
 }
 DEFINE_LUA_FUNCTION(memory_writedword, "address,value")
@@ -2188,6 +2189,29 @@ DEFINE_LUA_FUNCTION(state_load, "location[,option]")
 	}
 }
 
+// savestate.rewind([frames])
+// goes back to the newest state held by the rewind buffer that is at least the given number of frames old (1 by default)
+// returns false if the rewind buffer is empty
+DEFINE_LUA_FUNCTION(state_rewind, "[frames]")
+{
+	if(FailVerifyAtFrameBoundary(L, "savestate.rewind", 2,2))
+		return 0;
+
+	int frames = luaL_optinteger(L,1,1);
+	lua_pushboolean(L, rewind_step(frames));
+	return 1;
+}
+
+// savestate.setrewind(interval, capacity)
+// captures a rewind state every interval frames, keeping up to capacity of them. a capacity of 0 turns rewinding off
+DEFINE_LUA_FUNCTION(state_setrewind, "interval,capacity")
+{
+	int interval = luaL_checkinteger(L,1);
+	int capacity = luaL_checkinteger(L,2);
+	rewind_setup(interval, capacity);
+	return 0;
+}
+
 // savestate.loadscriptdata(location)
 // returns the user data associated with the given savestate
 // without actually loading the rest of that savestate or calling any callbacks.
@@ -4910,6 +4934,8 @@ static const struct luaL_reg statelib [] =
 	{"create", state_create},
 	{"save", state_save},
 	{"load", state_load},
+	{"rewind", state_rewind},
+	{"setrewind", state_setrewind},
 #ifndef PUBLIC_RELEASE
 	{"verify", state_verify}, // for desync catching
 #endif
@@ -5767,6 +5793,7 @@ static void CalculateMemHookRegions(LuaMemHookType hookType)
 		++iter;
 	}
 	hookedRegions[hookType].Calculate(hookedBytes);
+	MMU_TLBRebuild();
 }
 
 
@@ -175,6 +175,30 @@ struct TieredRegion
 	Region<0x1000> mid;
 	Region<0> narrow;
 
+	// one bit per 4KB page of the address space, set if any hooked byte lies in that page,
+	// so that an access to an unhooked page is rejected with a single bit test.
+	// left empty when nothing is hooked.
+	enum { PAGE_SHIFT = 12 };
+	std::vector<unsigned int> pages;
+
+	void CalculatePages(const std::vector<unsigned int>& bytes)
+	{
+		pages.clear();
+		if(bytes.empty())
+			return;
+
+		pages.resize(1u << (32 - PAGE_SHIFT - 5));
+		std::vector<unsigned int>::const_iterator iter = bytes.begin();
+		std::vector<unsigned int>::const_iterator end = bytes.end();
+		for(; iter != end; ++iter)
+			pages[*iter >> (PAGE_SHIFT + 5)] |= 1u << ((*iter >> PAGE_SHIFT) & 31);
+	}
+
+	FORCEINLINE bool PageHooked(unsigned int address) const
+	{
+		return (pages[address >> (PAGE_SHIFT + 5)] >> ((address >> PAGE_SHIFT) & 31)) & 1;
+	}
+
 	void Calculate(std::vector<unsigned int>& bytes)
 	{
 		std::sort(bytes.begin(), bytes.end());
@@ -182,6 +206,7 @@ struct TieredRegion
 		broad.Calculate(bytes);
 		mid.Calculate(bytes);
 		narrow.Calculate(bytes);
+		CalculatePages(bytes);
 	}
 
 	TieredRegion()
@@ -198,7 +223,7 @@ struct TieredRegion
 	// note: it is illegal to call this if NotEmpty() returns 0
 	FORCEINLINE bool Contains(unsigned int address, int size)
 	{
-		return broad.islands[0].Contains(address,size) &&
+		return (PageHooked(address) || PageHooked(address+size-1)) &&
 		       mid.Contains(address,size) &&
 			   narrow.Contains(address,size);
 	}
@@ -34,6 +34,14 @@
 #include "utils/xstring.h"
 #include "emufile.h"
 
+#include <limits.h>
+#include <rthreads/rthreads.h>
+#ifdef HOST_WINDOWS
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 //#define _DONT_SAVE_BACKUP
 //#define _MCLOG
 
@@ -106,6 +114,183 @@ const SAVE_TYPE save_types[] = {
 	{"FLASH 512Mbit",	MC_TYPE_FLASH,		MC_SIZE_512MBITS	, 3}
 };
 
+//the save file, held in memory so that the emulator never waits on the disk.
+//every write widens a dirty range, and fflush() (called when the game finishes a write command) only
+//wakes the writer thread, which copies the dirty range out and writes it back on its own. the writer
+//also wakes up every CommonSettings.backupFlushInterval ms, so that nothing stays unwritten for long,
+//and a burst of writes between wakeups goes out as one. sync() writes everything out on the calling
+//thread and makes sure it reached the disk; it is what closing the file does.
+class EMUFILE_BACKUP : public EMUFILE_MEMORY
+{
+	EMUFILE_FILE *_disk;
+	slock_t *_lock;   //guards vec, len and the dirty state against the writer's copy
+	slock_t *_ioLock; //serializes writing to _disk
+	scond_t *_cond;
+	sthread_t *_thread;
+	bool _quit;
+	bool _wake;
+	s32 _dirtyBegin, _dirtyEnd;
+	bool _resized;
+
+	void markDirty(s32 begin, s32 end)
+	{
+		if (begin < _dirtyBegin) _dirtyBegin = begin;
+		if (end > _dirtyEnd) _dirtyEnd = end;
+	}
+
+	//called with _lock held. the lock is let go during the disk write, so the emulator can keep running
+	void writeback(bool commit)
+	{
+		slock_lock(_ioLock);
+
+		const s32 begin = _dirtyBegin;
+		const s32 end = std::min(_dirtyEnd, len);
+		const s32 fileLen = len;
+		const bool resized = _resized;
+		std::vector<u8> data;
+		if (begin < end)
+			data.assign(vec->begin() + begin, vec->begin() + end);
+		_dirtyBegin = INT_MAX;
+		_dirtyEnd = 0;
+		_resized = false;
+
+		slock_unlock(_lock);
+
+		if (!data.empty())
+		{
+			_disk->fseek(begin, SEEK_SET);
+			_disk->fwrite(&data[0], data.size());
+		}
+		if (resized)
+			_disk->truncate(fileLen);
+		if (!data.empty() || resized || commit)
+			_disk->fflush();
+		if (commit)
+		{
+#ifdef HOST_WINDOWS
+			_commit(_fileno(_disk->get_fp()));
+#else
+			fsync(fileno(_disk->get_fp()));
+#endif
+		}
+
+		slock_lock(_lock);
+		slock_unlock(_ioLock);
+	}
+
+	static void writer(void *param)
+	{
+		EMUFILE_BACKUP *self = (EMUFILE_BACKUP *)param;
+		slock_lock(self->_lock);
+		while (!self->_quit)
+		{
+			if (!self->_wake)
+			{
+				if (CommonSettings.backupFlushInterval > 0)
+					scond_wait_timeout(self->_cond, self->_lock, (int64_t)CommonSettings.backupFlushInterval * 1000);
+				else
+					scond_wait(self->_cond, self->_lock);
+			}
+			self->_wake = false;
+			if (!self->_quit)
+				self->writeback(false);
+		}
+		slock_unlock(self->_lock);
+	}
+
+public:
+	EMUFILE_BACKUP(const std::string &fname, bool exists)
+		: _lock(NULL), _ioLock(NULL), _cond(NULL), _thread(NULL), _quit(false), _wake(false)
+		, _dirtyBegin(INT_MAX), _dirtyEnd(0), _resized(false)
+	{
+		//always open with rb+, since EMUFILE_FILE::truncate() reopens the file with the same mode
+		if (!exists)
+		{
+			EMUFILE_FILE create(fname, "wb");
+		}
+		_disk = new EMUFILE_FILE(fname, "rb+");
+		if (!is_open())
+			return;
+
+		const s32 size = _disk->size();
+		if (size > 0)
+		{
+			vec->resize(size);
+			_disk->fseek(0, SEEK_SET);
+			_disk->fread(&(*vec)[0], size);
+		}
+		len = size;
+
+		_lock = slock_new();
+		_ioLock = slock_new();
+		_cond = scond_new();
+		_thread = sthread_create(&EMUFILE_BACKUP::writer, this);
+	}
+
+	~EMUFILE_BACKUP()
+	{
+		if (_thread != NULL)
+		{
+			slock_lock(_lock);
+			_quit = true;
+			scond_signal(_cond);
+			slock_unlock(_lock);
+			sthread_join(_thread);
+
+			sync();
+
+			scond_free(_cond);
+			slock_free(_ioLock);
+			slock_free(_lock);
+		}
+		delete _disk;
+	}
+
+	bool is_open() { return _disk->get_fp() != NULL; }
+
+	void sync()
+	{
+		if (_lock == NULL) return;
+		slock_lock(_lock);
+		writeback(true);
+		slock_unlock(_lock);
+	}
+
+	virtual size_t fwrite(const void *ptr, size_t bytes)
+	{
+		slock_lock(_lock);
+		markDirty(pos, pos + (s32)bytes);
+		const size_t ret = EMUFILE_MEMORY::fwrite(ptr, bytes);
+		slock_unlock(_lock);
+		return ret;
+	}
+
+	virtual int fseek(int offset, int origin)
+	{
+		//seeking may grow the buffer
+		slock_lock(_lock);
+		const int ret = EMUFILE_MEMORY::fseek(offset, origin);
+		slock_unlock(_lock);
+		return ret;
+	}
+
+	virtual void truncate(s32 length)
+	{
+		slock_lock(_lock);
+		EMUFILE_MEMORY::truncate(length);
+		_resized = true;
+		slock_unlock(_lock);
+	}
+
+	virtual void fflush()
+	{
+		slock_lock(_lock);
+		_wake = true;
+		scond_signal(_cond);
+		slock_unlock(_lock);
+	}
+};
+
 
 //forces the currently selected backup type to be current
 //(can possibly be used to repair poorly chosen save types discovered late in gameplay i.e. pokemon gamers)
@@ -119,6 +304,19 @@ void backup_setManualBackupType(int type)
 	CommonSettings.manualBackupType = type;
 }
 
+//the NDSInstance whose save file the backup device opens. instance 0 uses the ROM's own .dsv
+static u32 backupInstanceID = 0;
+
+void backup_selectInstanceFile(u32 instanceID)
+{
+	if (instanceID == backupInstanceID)
+		return;
+
+	//reopening the backup device closes (and writes out) the previous instance's file
+	backupInstanceID = instanceID;
+	reconstruct(&MMU_new.backupDevice);
+}
+
 bool BackupDevice::save_state(EMUFILE &os)
 {
 	u32 savePos = this->_fpMC->ftell();
@@ -230,6 +428,11 @@ BackupDevice::BackupDevice()
 	char filePathStr[MAX_PATH] = {0};
 	memset(filePathStr, 0, MAX_PATH);
 	path.getpathnoext(path.BATTERY, filePathStr);
+	if (backupInstanceID != 0)
+	{
+		const size_t len = strlen(filePathStr);
+		snprintf(filePathStr + len, MAX_PATH - len, ".%u", backupInstanceID);
+	}
 	_fileName = std::string(filePathStr) + ".dsv";
 
 	MCLOG("MC: %s\n", _fileName.c_str());
@@ -326,8 +529,9 @@ BackupDevice::BackupDevice()
 		}
 	}
 
-	_fpMC = new EMUFILE_FILE(_fileName, fexists?"rb+" : "wb+");
-	const bool fileCanReadWrite = (_fpMC->get_fp() != NULL);
+	EMUFILE_BACKUP *fpBackup = new EMUFILE_BACKUP(_fileName, fexists);
+	_fpMC = fpBackup;
+	const bool fileCanReadWrite = fpBackup->is_open();
 	if (!fileCanReadWrite)
 	{
 		delete _fpMC;
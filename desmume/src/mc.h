@@ -207,6 +207,8 @@ private:
 
 void backup_setManualBackupType(int type);
 void backup_forceManualBackupType();
+//opens the save file of the given NDSInstance in place of the current one
+void backup_selectInstanceFile(u32 instanceID);
 
 struct SAVE_TYPE
 {
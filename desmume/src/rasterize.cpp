@@ -41,6 +41,8 @@
 #include <assert.h>
 #include <math.h>
 #include <string.h>
+#include <features/features_cpu.h>
+#include <rthreads/rthreads.h>
 
 #if defined(_MSC_VER) && _MSC_VER == 1600
 #define SLEEP_HACK_2011
@@ -1288,11 +1290,19 @@ void RasterizerUnit<RENDERER>::SetRenderer(SoftRasterizerRenderer *theRenderer)
 	this->_softRender = theRenderer;
 }
 
+template<bool RENDERER>
+void RasterizerUnit<RENDERER>::SetPolyBin(const SoftRasterizerPolyBin *polyBin)
+{
+	this->_polyBin = polyBin;
+}
+
 template<bool RENDERER> template <bool SLI, bool USELINEHACK>
 FORCEINLINE void RasterizerUnit<RENDERER>::Render()
 {
-	const size_t clippedPolyCount = this->_softRender->GetClippedPolyCount();
-	if (clippedPolyCount == 0)
+	// If this unit has a polygon bin, then only the polygons that touch its lines need to be visited.
+	const bool useBin = SLI && (this->_polyBin != NULL);
+	const size_t renderPolyCount = (useBin) ? this->_polyBin->polyIndex.size() : this->_softRender->GetClippedPolyCount();
+	if (renderPolyCount == 0)
 	{
 		return;
 	}
@@ -1304,17 +1314,19 @@ FORCEINLINE void RasterizerUnit<RENDERER>::Render()
 	const SoftRasterizerPrecalculation *softRastPrecalc = this->_softRender->GetPrecalculationList();
 	
 	const POLY *rawPolyList = this->_softRender->GetRawPolyList();
-	const CPoly &firstClippedPoly = this->_softRender->GetClippedPolyByIndex(0);
+	const size_t firstPolyIndex = (useBin) ? this->_polyBin->polyIndex[0] : 0;
+	const CPoly &firstClippedPoly = this->_softRender->GetClippedPolyByIndex(firstPolyIndex);
 	const POLY &firstPoly = rawPolyList[firstClippedPoly.index];
 	POLYGON_ATTR polyAttr = firstPoly.attribute;
 	TEXIMAGE_PARAM lastTexParams = firstPoly.texParam;
 	u32 lastTexPalette = firstPoly.texPalette;
 	
-	this->_SetupTexture(firstPoly, 0);
+	this->_SetupTexture(firstPoly, firstPolyIndex);
 
 	//iterate over polys
-	for (size_t i = 0; i < clippedPolyCount; i++)
+	for (size_t renderIndex = 0; renderIndex < renderPolyCount; renderIndex++)
 	{
+		const size_t i = (useBin) ? this->_polyBin->polyIndex[renderIndex] : renderIndex;
 		if (!RENDERER) _debug_thisPoly = (i == this->_softRender->_debug_drawClippedUserPoly);
 		
 		const CPoly &clippedPoly = this->_softRender->GetClippedPolyByIndex(i);
@@ -1439,18 +1451,10 @@ static void* SoftRasterizer_RunClearFramebuffer(void *arg)
 	return NULL;
 }
 
-static void* SoftRasterizer_RunRenderEdgeMarkAndFog(void *arg)
-{
-	SoftRasterizerPostProcessParams *params = (SoftRasterizerPostProcessParams *)arg;
-	params->renderer->RenderEdgeMarkingAndFog(*params);
-	
-	return NULL;
-}
-
-static void* SoftRasterizer_RunClearUsingValues(void *arg)
+static void* SoftRasterizer_RunLineChunks(void *arg)
 {
-	SoftRasterizerClearParam *param = (SoftRasterizerClearParam *)arg;
-	param->renderer->ClearUsingValues_Execute(param->startPixel, param->endPixel);
+	SoftRasterizerWorkerParam *param = (SoftRasterizerWorkerParam *)arg;
+	param->renderer->ProcessLineChunks(param->workerIndex);
 	
 	return NULL;
 }
@@ -1575,6 +1579,12 @@ void SoftRasterizerTexture::Load()
 	{
 		this->Unpack<TexFormat_15bpp>((u32 *)this->_renderData);
 	}
+	else if (this->_ReadUpscaleCache(this->_scalingFactor, this->_customBuffer))
+	{
+		// The upscaled texture came from the disk cache, so neither the unpacked texture
+		// nor the deposterized one will be needed.
+		ColorspaceConvertBuffer8888To6665<false, false>(this->_renderData, this->_renderData, this->_renderWidth * this->_renderHeight);
+	}
 	else
 	{
 		u32 *textureSrc = this->_unpackData;
@@ -1591,10 +1601,12 @@ void SoftRasterizerTexture::Load()
 		{
 			case 2:
 				this->_Upscale<2>(textureSrc, this->_customBuffer);
+				this->_WriteUpscaleCache(2, this->_customBuffer);
 				break;
 				
 			case 4:
 				this->_Upscale<4>(textureSrc, this->_customBuffer);
+				this->_WriteUpscaleCache(4, this->_customBuffer);
 				break;
 				
 			default:
@@ -1781,6 +1793,27 @@ SoftRasterizerRenderer::SoftRasterizerRenderer()
 	_enableFragmentSamplingHack = CommonSettings.GFX3D_TXTHack;
 	
 	_HACK_viewer_rasterizerUnit.SetSLI(0, (u32)_framebufferHeight, false);
+	_HACK_viewer_rasterizerUnit.SetPolyBin(NULL);
+	
+	_postprocessParam.renderer = this;
+	_postprocessParam.startLine = 0;
+	_postprocessParam.endLine = _framebufferHeight;
+	_postprocessParam.enableEdgeMarking = true;
+	_postprocessParam.enableFog = true;
+	_postprocessParam.fogColor = 0x80FFFFFF;
+	_postprocessParam.fogAlphaOnly = false;
+	
+	_lineChunkCount = 0;
+	_linesPerChunk = _framebufferHeight;
+	_nextLineChunk = 0;
+	_currentPass = SoftRasterizerPass_Clear;
+	
+	_pendingTextureList.reserve(CLIPPED_POLYLIST_SIZE);
+	_nextPendingTexture = 0;
+	_pendingTextureLoadedCount = 0;
+	_pendingTextureLock = NULL;
+	_pendingTextureCondition = NULL;
+	_enableParallelTextureUnpack = CommonSettings.GFX3D_Renderer_TextureParallelUnpack;
 	
 	const size_t coreCount = CommonSettings.num_cores;
 	_threadCount = coreCount;
@@ -1794,51 +1827,28 @@ SoftRasterizerRenderer::SoftRasterizerRenderer()
 	{
 		_threadCount = 0;
 		
-		_nativeLinesPerThread = GPU_FRAMEBUFFER_NATIVE_HEIGHT;
-		_nativePixelsPerThread = GPU_FRAMEBUFFER_NATIVE_WIDTH * GPU_FRAMEBUFFER_NATIVE_HEIGHT;
-		_customLinesPerThread = _framebufferHeight;
-		_customPixelsPerThread = _framebufferPixCount;
-		
-		_threadPostprocessParam[0].renderer = this;
-		_threadPostprocessParam[0].startLine = 0;
-		_threadPostprocessParam[0].endLine = _framebufferHeight;
-		_threadPostprocessParam[0].enableEdgeMarking = true;
-		_threadPostprocessParam[0].enableFog = true;
-		_threadPostprocessParam[0].fogColor = 0x80FFFFFF;
-		_threadPostprocessParam[0].fogAlphaOnly = false;
-		
-		_threadClearParam[0].renderer = this;
-		_threadClearParam[0].startPixel = 0;
-		_threadClearParam[0].endPixel = _framebufferPixCount;
-		
-		_rasterizerUnit[0].SetSLI((u32)_threadPostprocessParam[0].startLine, (u32)_threadPostprocessParam[0].endLine, false);
+		_rasterizerUnit[0].SetSLI(0, (u32)_framebufferHeight, false);
 		_rasterizerUnit[0].SetRenderer(this);
+		_rasterizerUnit[0].SetPolyBin(NULL);
 	}
 	else
 	{
 		_task = new Task[_threadCount];
 		
-		_nativeLinesPerThread = GPU_FRAMEBUFFER_NATIVE_HEIGHT / _threadCount;
-		_nativePixelsPerThread = (GPU_FRAMEBUFFER_NATIVE_WIDTH * GPU_FRAMEBUFFER_NATIVE_HEIGHT)  / _threadCount;
-		_customLinesPerThread = _framebufferHeight / _threadCount;
-		_customPixelsPerThread = _framebufferPixCount / _threadCount;
+		_pendingTextureLock = slock_new();
+		_pendingTextureCondition = scond_new();
+		
+		_UpdateLineChunks(1, _framebufferPixCount);
 		
 		for (size_t i = 0; i < _threadCount; i++)
 		{
-			_threadPostprocessParam[i].renderer = this;
-			_threadPostprocessParam[i].startLine = i * _customLinesPerThread;
-			_threadPostprocessParam[i].endLine = (i < _threadCount - 1) ? (i + 1) * _customLinesPerThread : _framebufferHeight;
-			_threadPostprocessParam[i].enableEdgeMarking = true;
-			_threadPostprocessParam[i].enableFog = true;
-			_threadPostprocessParam[i].fogColor = 0x80FFFFFF;
-			_threadPostprocessParam[i].fogAlphaOnly = false;
+			_workerParam[i].renderer = this;
+			_workerParam[i].workerIndex = i;
 			
-			_threadClearParam[i].renderer = this;
-			_threadClearParam[i].startPixel = i * _customPixelsPerThread;
-			_threadClearParam[i].endPixel = (i < _threadCount - 1) ? (i + 1) * _customPixelsPerThread : _framebufferPixCount;
-			
-			_rasterizerUnit[i].SetSLI((u32)_threadPostprocessParam[i].startLine, (u32)_threadPostprocessParam[i].endLine, false);
+			// The line range and polygon bin of each unit are assigned per line chunk.
+			_rasterizerUnit[i].SetSLI(0, (u32)_framebufferHeight, false);
 			_rasterizerUnit[i].SetRenderer(this);
+			_rasterizerUnit[i].SetPolyBin(NULL);
 			
 			char name[16];
 			snprintf(name, 16, "rasterizer %d", (int)i);
@@ -1877,6 +1887,18 @@ SoftRasterizerRenderer::~SoftRasterizerRenderer()
 	delete[] this->_task;
 	this->_task = NULL;
 	
+	if (this->_pendingTextureCondition != NULL)
+	{
+		scond_free(this->_pendingTextureCondition);
+		this->_pendingTextureCondition = NULL;
+	}
+	
+	if (this->_pendingTextureLock != NULL)
+	{
+		slock_free(this->_pendingTextureLock);
+		this->_pendingTextureLock = NULL;
+	}
+	
 	delete this->_framebufferAttributes;
 	this->_framebufferAttributes = NULL;
 	
@@ -1916,6 +1938,13 @@ void SoftRasterizerRenderer::GetAndLoadAllTextures()
 {
 	const POLY *rawPolyList = this->_rawPolyList;
 	
+	// The texture cache must be read here since it compares against VRAM, but the unpacking
+	// only needs the texture's own copy of the packed data. So when we have worker threads,
+	// leave the unpacking to them so that it runs alongside the emulation. 4x4 textures are
+	// the exception, since their unpacking reads the palette from VRAM (see _GetTextureFromPolygon()).
+	const bool willDeferLoad = this->_enableParallelTextureUnpack && (this->_threadCount > 0);
+	this->_pendingTextureList.clear();
+	
 	for (size_t i = 0; i < this->_clippedPolyCount; i++)
 	{
 		const CPoly &clippedPoly = this->_clippedPolyList[i];
@@ -1925,8 +1954,55 @@ void SoftRasterizerRenderer::GetAndLoadAllTextures()
 		//(otherwise on a multithreaded system there will be multiple writers--
 		//this SHOULD be read-only, although some day the texcache may collect statistics or something
 		//and then it won't be safe.
-		this->_textureList[i] = this->GetLoadedTextureFromPolygon(rawPoly, this->_enableTextureSampling);
+		this->_textureList[i] = this->_GetTextureFromPolygon(rawPoly, this->_enableTextureSampling, willDeferLoad);
 	}
+	
+	if (this->_pendingTextureList.size() > 1)
+	{
+		// Many polygons can share the same texture, but each texture must only be unpacked once.
+		std::sort(this->_pendingTextureList.begin(), this->_pendingTextureList.end());
+		this->_pendingTextureList.erase( std::unique(this->_pendingTextureList.begin(), this->_pendingTextureList.end()), this->_pendingTextureList.end() );
+	}
+	
+	this->_nextPendingTexture = 0;
+	this->_pendingTextureLoadedCount = 0;
+}
+
+void SoftRasterizerRenderer::_LoadPendingTextures()
+{
+	const size_t pendingCount = this->_pendingTextureList.size();
+	if (pendingCount == 0)
+	{
+		return;
+	}
+	
+	while (true)
+	{
+		const size_t textureIndex = (size_t)(atomic_inc_barrier32(&this->_nextPendingTexture) - 1);
+		if (textureIndex >= pendingCount)
+		{
+			break;
+		}
+		
+		this->_pendingTextureList[textureIndex]->Load();
+		
+		slock_lock(this->_pendingTextureLock);
+		this->_pendingTextureLoadedCount++;
+		if (this->_pendingTextureLoadedCount == pendingCount)
+		{
+			scond_broadcast(this->_pendingTextureCondition);
+		}
+		slock_unlock(this->_pendingTextureLock);
+	}
+	
+	// Any line chunk may sample a texture that another thread is still unpacking,
+	// so wait for all of them before rasterizing.
+	slock_lock(this->_pendingTextureLock);
+	while (this->_pendingTextureLoadedCount < pendingCount)
+	{
+		scond_wait(this->_pendingTextureCondition, this->_pendingTextureLock);
+	}
+	slock_unlock(this->_pendingTextureLock);
 }
 
 void SoftRasterizerRenderer::RasterizerPrecalculate()
@@ -1994,11 +2070,195 @@ void SoftRasterizerRenderer::RasterizerPrecalculate()
 	}
 }
 
+void SoftRasterizerRenderer::_UpdateLineChunks(const size_t pixelAlignment, const size_t clearPixCount)
+{
+	if (this->_threadCount == 0)
+	{
+		this->_lineChunkCount = 0;
+		this->_linesPerChunk = this->_framebufferHeight;
+		return;
+	}
+	
+	const size_t w = this->_framebufferWidth;
+	const size_t h = this->_framebufferHeight;
+	const size_t chunkCount = min<size_t>(this->_threadCount * SOFTRASTERIZER_LINE_CHUNKS_PER_THREAD, h);
+	const size_t linesPerChunk = h / chunkCount;
+	
+	for (size_t c = 0; c < chunkCount; c++)
+	{
+		SoftRasterizerLineChunk &chunk = this->_lineChunk[c];
+		const bool isLastChunk = (c == chunkCount - 1);
+		
+		chunk.startLine = c * linesPerChunk;
+		chunk.endLine = (isLastChunk) ? h : (c + 1) * linesPerChunk;
+		
+		// Clearing works on pixel ranges, which SIMD renderers need aligned to their vector size.
+		chunk.startPixel = ((chunk.startLine * w) / pixelAlignment) * pixelAlignment;
+		chunk.endPixel = (isLastChunk) ? clearPixCount : ((chunk.endLine * w) / pixelAlignment) * pixelAlignment;
+		
+		chunk.polyBin.polyIndex.clear();
+		
+		for (size_t p = 0; p < SoftRasterizerPassCount; p++)
+		{
+			chunk.workerIndex[p] = 0;
+			chunk.elapsedTimeUsec[p] = 0;
+		}
+	}
+	
+	this->_lineChunkCount = chunkCount;
+	this->_linesPerChunk = linesPerChunk;
+}
+
+void SoftRasterizerRenderer::_DispatchLineChunkPass(const SoftRasterizerPassID pass)
+{
+	this->_currentPass = pass;
+	this->_nextLineChunk = 0;
+	
+	for (size_t i = 0; i < this->_threadCount; i++)
+	{
+		this->_task[i].execute(&SoftRasterizer_RunLineChunks, &this->_workerParam[i]);
+	}
+}
+
+void SoftRasterizerRenderer::_FinishLineChunkPass()
+{
+	for (size_t i = 0; i < this->_threadCount; i++)
+	{
+		this->_task[i].finish();
+	}
+}
+
+void SoftRasterizerRenderer::ProcessLineChunks(const size_t workerIndex)
+{
+	const SoftRasterizerPassID pass = this->_currentPass;
+	RasterizerUnit<true> &unit = this->_rasterizerUnit[workerIndex];
+	
+	if (pass == SoftRasterizerPass_Rasterize)
+	{
+		this->_LoadPendingTextures();
+	}
+	
+	while (true)
+	{
+		const size_t chunkIndex = (size_t)(atomic_inc_barrier32(&this->_nextLineChunk) - 1);
+		if (chunkIndex >= this->_lineChunkCount)
+		{
+			break;
+		}
+		
+		SoftRasterizerLineChunk &chunk = this->_lineChunk[chunkIndex];
+		const u64 startTime = (u64)cpu_features_get_time_usec();
+		
+		switch (pass)
+		{
+			case SoftRasterizerPass_Clear:
+				this->ClearUsingValues_Execute(chunk.startPixel, chunk.endPixel);
+				break;
+				
+			case SoftRasterizerPass_Rasterize:
+			{
+				unit.SetSLI((u32)chunk.startLine, (u32)chunk.endLine, false);
+				unit.SetPolyBin(&chunk.polyBin);
+				
+				if (this->_enableLineHack)
+				{
+					unit.Render<true, true>();
+				}
+				else
+				{
+					unit.Render<true, false>();
+				}
+				break;
+			}
+				
+			case SoftRasterizerPass_EdgeMarkAndFog:
+			{
+				SoftRasterizerPostProcessParams chunkParam = this->_postprocessParam;
+				chunkParam.startLine = chunk.startLine;
+				chunkParam.endLine = chunk.endLine;
+				
+				this->RenderEdgeMarkingAndFog(chunkParam);
+				break;
+			}
+				
+			default:
+				break;
+		}
+		
+		chunk.workerIndex[pass] = workerIndex;
+		chunk.elapsedTimeUsec[pass] = (u64)cpu_features_get_time_usec() - startTime;
+	}
+}
+
+size_t SoftRasterizerRenderer::GetLineChunkCount() const
+{
+	return this->_lineChunkCount;
+}
+
+const SoftRasterizerLineChunk* SoftRasterizerRenderer::GetLineChunkList() const
+{
+	return this->_lineChunk;
+}
+
+void SoftRasterizerRenderer::BinPolygonsByLine()
+{
+	if (this->_lineChunkCount == 0)
+	{
+		return;
+	}
+	
+	for (size_t c = 0; c < this->_lineChunkCount; c++)
+	{
+		this->_lineChunk[c].polyBin.polyIndex.clear();
+	}
+	
+	const s64 lastLine = (s64)this->_framebufferHeight - 1;
+	
+	for (size_t i = 0; i < this->_clippedPolyCount; i++)
+	{
+		const size_t vertCount = (size_t)this->_clippedPolyList[i].type;
+		const SoftRasterizerPrecalculation *polyPrecalc = &this->_precalc[i * MAX_CLIPPED_VERTS];
+		
+		s64 minY = polyPrecalc[0].positionCeil.y;
+		s64 maxY = minY;
+		
+		for (size_t j = 1; j < vertCount; j++)
+		{
+			minY = min(minY, polyPrecalc[j].positionCeil.y);
+			maxY = max(maxY, polyPrecalc[j].positionCeil.y);
+		}
+		
+		// Scanlines are drawn on lines [minY, maxY), but the line hack may also draw on line maxY
+		// for a flat polygon, so treat maxY as inclusive.
+		if ( (maxY < 0) || (minY > lastLine) )
+		{
+			continue;
+		}
+		
+		minY = max<s64>(minY, 0);
+		maxY = min<s64>(maxY, lastLine);
+		
+		size_t c = min<size_t>((size_t)minY / this->_linesPerChunk, this->_lineChunkCount - 1);
+		for (; (c < this->_lineChunkCount) && ((s64)this->_lineChunk[c].startLine <= maxY); c++)
+		{
+			this->_lineChunk[c].polyBin.polyIndex.push_back((u32)i);
+		}
+	}
+}
+
 Render3DError SoftRasterizerRenderer::ApplyRenderingSettings(const GFX3D_State &renderState)
 {
+	// Texture loads on the worker threads read the texture cache directory, which
+	// Render3D::ApplyRenderingSettings() may change.
+	for (size_t i = 0; i < this->_threadCount; i++)
+	{
+		this->_task[i].finish();
+	}
+	
 	this->_enableHighPrecisionColorInterpolation = CommonSettings.GFX3D_HighResolutionInterpolateColor;
 	this->_enableLineHack = CommonSettings.GFX3D_LineHack;
 	this->_enableFragmentSamplingHack = CommonSettings.GFX3D_TXTHack;
+	this->_enableParallelTextureUnpack = CommonSettings.GFX3D_Renderer_TextureParallelUnpack;
 	
 	return Render3D::ApplyRenderingSettings(renderState);
 }
@@ -2050,6 +2310,8 @@ Render3DError SoftRasterizerRenderer::BeginRender(const GFX3D_State &renderState
 		this->_task[0].finish();
 	}
 	
+	this->BinPolygonsByLine();
+	
 	return RENDER3DERROR_NOERR;
 }
 
@@ -2058,21 +2320,7 @@ Render3DError SoftRasterizerRenderer::RenderGeometry()
 	// Render the geometry
 	if (this->_threadCount > 0)
 	{
-		if (this->_enableLineHack)
-		{
-			for (size_t i = 0; i < this->_threadCount; i++)
-			{
-				this->_task[i].execute(&SoftRasterizer_RunRasterizerUnit<true>, &this->_rasterizerUnit[i]);
-			}
-		}
-		else
-		{
-			for (size_t i = 0; i < this->_threadCount; i++)
-			{
-				this->_task[i].execute(&SoftRasterizer_RunRasterizerUnit<false>, &this->_rasterizerUnit[i]);
-			}
-		}
-		
+		this->_DispatchLineChunkPass(SoftRasterizerPass_Rasterize);
 		this->_renderGeometryNeedsFinish = true;
 	}
 	else
@@ -2271,6 +2519,11 @@ Render3DError SoftRasterizerRenderer::RenderEdgeMarkingAndFog(const SoftRasteriz
 }
 
 SoftRasterizerTexture* SoftRasterizerRenderer::GetLoadedTextureFromPolygon(const POLY &thePoly, bool enableTexturing)
+{
+	return this->_GetTextureFromPolygon(thePoly, enableTexturing, false);
+}
+
+SoftRasterizerTexture* SoftRasterizerRenderer::_GetTextureFromPolygon(const POLY &thePoly, bool enableTexturing, bool willDeferLoad)
 {
 	SoftRasterizerTexture *theTexture = (SoftRasterizerTexture *)texCache.GetTexture(thePoly.texParam, thePoly.texPalette);
 	if (theTexture == NULL)
@@ -2288,7 +2541,18 @@ SoftRasterizerTexture* SoftRasterizerRenderer::GetLoadedTextureFromPolygon(const
 	{
 		theTexture->SetUseDeposterize(this->_enableTextureDeposterize);
 		theTexture->SetScalingFactor(this->_textureScalingFactor);
-		theTexture->Load();
+		
+		// NDSTextureUnpack4x4() reads its palette live through MMU.texInfo.texPalSlot, which
+		// the CPU may rewrite or remap while the worker threads run, so 4x4 textures are always
+		// unpacked here on the emulation thread.
+		if (willDeferLoad && (packFormat != TEXMODE_4X4))
+		{
+			this->_pendingTextureList.push_back(theTexture);
+		}
+		else
+		{
+			theTexture->Load();
+		}
 	}
 	
 	return theTexture;
@@ -2341,24 +2605,14 @@ Render3DError SoftRasterizerRenderer::ClearUsingValues(const Color4u8 &clearColo
 	
 	if (doMultithreadedClear)
 	{
-		for (size_t threadIndex = 0; threadIndex < this->_threadCount; threadIndex++)
-		{
-			this->_task[threadIndex].execute(&SoftRasterizer_RunClearUsingValues, &this->_threadClearParam[threadIndex]);
-		}
+		this->_DispatchLineChunkPass(SoftRasterizerPass_Clear);
+		this->_FinishLineChunkPass();
 	}
 	else
 	{
 		this->ClearUsingValues_Execute(0, this->_framebufferPixCount);
 	}
 	
-	if (doMultithreadedClear)
-	{
-		for (size_t threadIndex = 0; threadIndex < this->_threadCount; threadIndex++)
-		{
-			this->_task[threadIndex].finish();
-		}
-	}
-	
 	return RENDER3DERROR_NOERR;
 }
 
@@ -2387,12 +2641,14 @@ Render3DError SoftRasterizerRenderer::EndRender()
 	{
 		if (this->_enableEdgeMark || this->_enableFog)
 		{
-			this->_threadPostprocessParam[0].enableEdgeMarking = this->_enableEdgeMark;
-			this->_threadPostprocessParam[0].enableFog = this->_enableFog;
-			this->_threadPostprocessParam[0].fogColor = this->currentRenderState->fogColor;
-			this->_threadPostprocessParam[0].fogAlphaOnly = (this->currentRenderState->DISP3DCNT.FogOnlyAlpha != 0);
+			this->_postprocessParam.startLine = 0;
+			this->_postprocessParam.endLine = this->_framebufferHeight;
+			this->_postprocessParam.enableEdgeMarking = this->_enableEdgeMark;
+			this->_postprocessParam.enableFog = this->_enableFog;
+			this->_postprocessParam.fogColor = this->currentRenderState->fogColor;
+			this->_postprocessParam.fogAlphaOnly = (this->currentRenderState->DISP3DCNT.FogOnlyAlpha != 0);
 			
-			this->RenderEdgeMarkingAndFog(this->_threadPostprocessParam[0]);
+			this->RenderEdgeMarkingAndFog(this->_postprocessParam);
 		}
 	}
 	
@@ -2410,10 +2666,7 @@ Render3DError SoftRasterizerRenderer::RenderFinish()
 	{
 		// Allow for the geometry rendering to finish.
 		this->_renderGeometryNeedsFinish = false;
-		for (size_t i = 0; i < this->_threadCount; i++)
-		{
-			this->_task[i].finish();
-		}
+		this->_FinishLineChunkPass();
 		
 		// Now that geometry rendering is finished on all threads, check the texture cache.
 		texCache.Evict();
@@ -2421,21 +2674,13 @@ Render3DError SoftRasterizerRenderer::RenderFinish()
 		// Do multithreaded post-processing.
 		if (this->_enableEdgeMark || this->_enableFog)
 		{
-			for (size_t i = 0; i < this->_threadCount; i++)
-			{
-				this->_threadPostprocessParam[i].enableEdgeMarking = this->_enableEdgeMark;
-				this->_threadPostprocessParam[i].enableFog = this->_enableFog;
-				this->_threadPostprocessParam[i].fogColor = this->currentRenderState->fogColor;
-				this->_threadPostprocessParam[i].fogAlphaOnly = (this->currentRenderState->DISP3DCNT.FogOnlyAlpha != 0);
-				
-				this->_task[i].execute(&SoftRasterizer_RunRenderEdgeMarkAndFog, &this->_threadPostprocessParam[i]);
-			}
+			this->_postprocessParam.enableEdgeMarking = this->_enableEdgeMark;
+			this->_postprocessParam.enableFog = this->_enableFog;
+			this->_postprocessParam.fogColor = this->currentRenderState->fogColor;
+			this->_postprocessParam.fogAlphaOnly = (this->currentRenderState->DISP3DCNT.FogOnlyAlpha != 0);
 			
-			// Allow for post-processing to finish.
-			for (size_t i = 0; i < this->_threadCount; i++)
-			{
-				this->_task[i].finish();
-			}
+			this->_DispatchLineChunkPass(SoftRasterizerPass_EdgeMarkAndFog);
+			this->_FinishLineChunkPass();
 		}
 	}
 	
@@ -2474,32 +2719,11 @@ Render3DError SoftRasterizerRenderer::SetFramebufferSize(size_t w, size_t h)
 	
 	if (this->_threadCount == 0)
 	{
-		this->_customLinesPerThread = h;
-		this->_customPixelsPerThread = pixCount;
-		
-		this->_threadPostprocessParam[0].startLine = 0;
-		this->_threadPostprocessParam[0].endLine = h;
-		
-		this->_threadClearParam[0].startPixel = 0;
-		this->_threadClearParam[0].endPixel = pixCount;
-		
-		this->_rasterizerUnit[0].SetSLI((u32)this->_threadPostprocessParam[0].startLine, (u32)this->_threadPostprocessParam[0].endLine, false);
+		this->_rasterizerUnit[0].SetSLI(0, (u32)h, false);
 	}
 	else
 	{
-		this->_customLinesPerThread = h / this->_threadCount;
-		this->_customPixelsPerThread = pixCount / this->_threadCount;
-		
-		for (size_t i = 0; i < this->_threadCount; i++)
-		{
-			this->_threadPostprocessParam[i].startLine = i * this->_customLinesPerThread;
-			this->_threadPostprocessParam[i].endLine = (i < this->_threadCount - 1) ? (i + 1) * this->_customLinesPerThread : h;
-			
-			this->_threadClearParam[i].startPixel = i * this->_customPixelsPerThread;
-			this->_threadClearParam[i].endPixel = (i < this->_threadCount - 1) ? (i + 1) * this->_customPixelsPerThread : pixCount;
-			
-			this->_rasterizerUnit[i].SetSLI((u32)this->_threadPostprocessParam[i].startLine, (u32)this->_threadPostprocessParam[i].endLine, false);
-		}
+		this->_UpdateLineChunks(1, pixCount);
 	}
 	
 	return RENDER3DERROR_NOERR;
@@ -2510,22 +2734,9 @@ Render3DError SoftRasterizerRenderer::SetFramebufferSize(size_t w, size_t h)
 template <size_t SIMDBYTES>
 SoftRasterizer_SIMD<SIMDBYTES>::SoftRasterizer_SIMD()
 {
-	if (_threadCount == 0)
-	{
-		_threadClearParam[0].renderer = this;
-		_threadClearParam[0].startPixel = 0;
-		_threadClearParam[0].endPixel = _framebufferSIMDPixCount;
-	}
-	else
+	if (_threadCount > 0)
 	{
-		const size_t pixelsPerThread = ((_framebufferSIMDPixCount / SIMDBYTES) / _threadCount) * SIMDBYTES;
-		
-		for (size_t i = 0; i < _threadCount; i++)
-		{
-			_threadClearParam[i].renderer = this;
-			_threadClearParam[i].startPixel = i * pixelsPerThread;
-			_threadClearParam[i].endPixel = (i < _threadCount - 1) ? (i + 1) * pixelsPerThread : _framebufferSIMDPixCount;
-		}
+		_UpdateLineChunks(SIMDBYTES, _framebufferSIMDPixCount);
 	}
 }
 
@@ -2538,10 +2749,7 @@ Render3DError SoftRasterizer_SIMD<SIMDBYTES>::ClearUsingValues(const Color4u8 &c
 	
 	if (doMultithreadedClear)
 	{
-		for (size_t threadIndex = 0; threadIndex < this->_threadCount; threadIndex++)
-		{
-			this->_task[threadIndex].execute(&SoftRasterizer_RunClearUsingValues, &this->_threadClearParam[threadIndex]);
-		}
+		this->_DispatchLineChunkPass(SoftRasterizerPass_Clear);
 	}
 	else
 	{
@@ -2557,10 +2765,7 @@ Render3DError SoftRasterizer_SIMD<SIMDBYTES>::ClearUsingValues(const Color4u8 &c
 	
 	if (doMultithreadedClear)
 	{
-		for (size_t threadIndex = 0; threadIndex < this->_threadCount; threadIndex++)
-		{
-			this->_task[threadIndex].finish();
-		}
+		this->_FinishLineChunkPass();
 	}
 	
 	return RENDER3DERROR_NOERR;
@@ -2582,34 +2787,11 @@ Render3DError SoftRasterizer_SIMD<SIMDBYTES>::SetFramebufferSize(size_t w, size_
 	
 	if (this->_threadCount == 0)
 	{
-		this->_customLinesPerThread = h;
-		this->_customPixelsPerThread = pixCount;
-		
-		this->_threadPostprocessParam[0].startLine = 0;
-		this->_threadPostprocessParam[0].endLine = h;
-		
-		this->_threadClearParam[0].startPixel = 0;
-		this->_threadClearParam[0].endPixel = pixCount;
-		
-		this->_rasterizerUnit[0].SetSLI(this->_threadPostprocessParam[0].startLine, this->_threadPostprocessParam[0].endLine, false);
+		this->_rasterizerUnit[0].SetSLI(0, (u32)h, false);
 	}
 	else
 	{
-		const size_t pixelsPerThread = ((pixCount / SIMDBYTES) / this->_threadCount) * SIMDBYTES;
-		
-		this->_customLinesPerThread = h / this->_threadCount;
-		this->_customPixelsPerThread = pixelsPerThread / this->_threadCount;
-		
-		for (size_t i = 0; i < this->_threadCount; i++)
-		{
-			this->_threadPostprocessParam[i].startLine = i * this->_customLinesPerThread;
-			this->_threadPostprocessParam[i].endLine = (i < this->_threadCount - 1) ? (i + 1) * this->_customLinesPerThread : h;
-			
-			this->_threadClearParam[i].startPixel = i * pixelsPerThread;
-			this->_threadClearParam[i].endPixel = (i < this->_threadCount - 1) ? (i + 1) * pixelsPerThread : pixCount;
-			
-			this->_rasterizerUnit[i].SetSLI(this->_threadPostprocessParam[i].startLine, this->_threadPostprocessParam[i].endLine, false);
-		}
+		this->_UpdateLineChunks(SIMDBYTES, pixCount);
 	}
 	
 	return RENDER3DERROR_NOERR;
@@ -18,17 +18,27 @@
 #ifndef _RASTERIZE_H_
 #define _RASTERIZE_H_
 
+#include <vector>
+
 #include "render3D.h"
 #include "gfx3d.h"
 
 
 #define SOFTRASTERIZER_MAX_THREADS 32
 
+// The framebuffer is split into this many line chunks per thread. Threads pull chunks
+// from a shared queue, so a thread that gets an empty chunk simply takes the next one.
+#define SOFTRASTERIZER_LINE_CHUNKS_PER_THREAD 8
+#define SOFTRASTERIZER_MAX_LINE_CHUNKS (SOFTRASTERIZER_MAX_THREADS * SOFTRASTERIZER_LINE_CHUNKS_PER_THREAD)
+
 extern GPU3DInterface gpu3DRasterize;
 
 class Task;
 class SoftRasterizerRenderer;
+class SoftRasterizerTexture;
 struct edge_fx_fl;
+typedef struct slock slock_t;
+typedef struct scond scond_t;
 
 struct SoftRasterizerPrecalculation
 {
@@ -48,11 +58,40 @@ struct SoftRasterizerPrecalculation
 };
 typedef struct SoftRasterizerPrecalculation SoftRasterizerPrecalculation;
 
-struct SoftRasterizerClearParam
+enum SoftRasterizerPassID
 {
-	SoftRasterizerRenderer *renderer;
+	SoftRasterizerPass_Clear			= 0,
+	SoftRasterizerPass_Rasterize		= 1,
+	SoftRasterizerPass_EdgeMarkAndFog	= 2,
+	
+	SoftRasterizerPassCount
+};
+
+struct SoftRasterizerPolyBin
+{
+	std::vector<u32> polyIndex; // Indices into the clipped polygon list, kept in drawing order
+};
+typedef struct SoftRasterizerPolyBin SoftRasterizerPolyBin;
+
+struct SoftRasterizerLineChunk
+{
+	size_t startLine;
+	size_t endLine;
 	size_t startPixel;
 	size_t endPixel;
+	
+	SoftRasterizerPolyBin polyBin;
+	
+	// Statistics from the most recent execution of each pass, for checking thread utilization.
+	size_t workerIndex[SoftRasterizerPassCount];
+	u64 elapsedTimeUsec[SoftRasterizerPassCount];
+};
+typedef struct SoftRasterizerLineChunk SoftRasterizerLineChunk;
+
+struct SoftRasterizerWorkerParam
+{
+	SoftRasterizerRenderer *renderer;
+	size_t workerIndex;
 };
 
 struct SoftRasterizerPostProcessParams
@@ -120,6 +159,7 @@ protected:
 	u32 _SLI_endLine;
 	
 	SoftRasterizerRenderer *_softRender;
+	const SoftRasterizerPolyBin *_polyBin;
 	SoftRasterizerTexture *_currentTexture;
 	const NDSVertex *_currentVtx[MAX_CLIPPED_VERTS];
 	const SoftRasterizerPrecalculation *_currentPrecalc[MAX_CLIPPED_VERTS];
@@ -141,6 +181,7 @@ protected:
 public:
 	void SetSLI(u32 startLine, u32 endLine, bool debug);
 	void SetRenderer(SoftRasterizerRenderer *theRenderer);
+	void SetPolyBin(const SoftRasterizerPolyBin *polyBin);
 	template<bool SLI, bool USELINEHACK> FORCEINLINE void Render();
 };
 
@@ -161,17 +202,27 @@ private:
 	
 protected:
 	Task *_task;
-	SoftRasterizerClearParam _threadClearParam[SOFTRASTERIZER_MAX_THREADS];
-	SoftRasterizerPostProcessParams _threadPostprocessParam[SOFTRASTERIZER_MAX_THREADS];
+	SoftRasterizerWorkerParam _workerParam[SOFTRASTERIZER_MAX_THREADS];
+	SoftRasterizerPostProcessParams _postprocessParam;
 	
 	RasterizerUnit<true> _rasterizerUnit[SOFTRASTERIZER_MAX_THREADS];
 	RasterizerUnit<false> _HACK_viewer_rasterizerUnit;
 	
 	size_t _threadCount;
-	size_t _nativeLinesPerThread;
-	size_t _nativePixelsPerThread;
-	size_t _customLinesPerThread;
-	size_t _customPixelsPerThread;
+	
+	SoftRasterizerLineChunk _lineChunk[SOFTRASTERIZER_MAX_LINE_CHUNKS];
+	size_t _lineChunkCount;
+	size_t _linesPerChunk;
+	volatile s32 _nextLineChunk;
+	SoftRasterizerPassID _currentPass;
+	
+	// Textures that were found in BeginRender() but still need to be unpacked. The worker
+	// threads unpack these at the start of the rasterize pass.
+	std::vector<SoftRasterizerTexture *> _pendingTextureList;
+	volatile s32 _nextPendingTexture;
+	size_t _pendingTextureLoadedCount;
+	slock_t *_pendingTextureLock;
+	scond_t *_pendingTextureCondition;
 	
 	SoftRasterizerPrecalculation *_precalc;
 	
@@ -183,10 +234,16 @@ protected:
 	
 	bool _enableHighPrecisionColorInterpolation;
 	bool _enableLineHack;
+	bool _enableParallelTextureUnpack;
 	
 	// SoftRasterizer-specific methods
 	void _UpdateEdgeMarkColorTable(const u16 *edgeMarkColorTable);
 	void _UpdateFogTable(const u8 *fogDensityTable);
+	void _UpdateLineChunks(const size_t pixelAlignment, const size_t clearPixCount);
+	void _DispatchLineChunkPass(const SoftRasterizerPassID pass);
+	void _FinishLineChunkPass();
+	void _LoadPendingTextures();
+	SoftRasterizerTexture* _GetTextureFromPolygon(const POLY &thePoly, bool enableTexturing, bool willDeferLoad);
 	
 	// Base rendering methods
 	virtual Render3DError BeginRender(const GFX3D_State &renderState, const GFX3D_GeometryList &renderGList);
@@ -211,8 +268,13 @@ public:
 	
 	void GetAndLoadAllTextures();
 	void RasterizerPrecalculate();
+	void BinPolygonsByLine();
+	void ProcessLineChunks(const size_t workerIndex);
 	Render3DError RenderEdgeMarkingAndFog(const SoftRasterizerPostProcessParams &param);
 	
+	size_t GetLineChunkCount() const;
+	const SoftRasterizerLineChunk* GetLineChunkList() const;
+	
 	SoftRasterizerTexture* GetLoadedTextureFromPolygon(const POLY &thePoly, bool enableTexturing);
 	
 	const SoftRasterizerPrecalculation* GetPrecalculationList() const;
@@ -18,8 +18,23 @@
 
 #include "render3D.h"
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#include <file/file_path.h>
+#include <retro_stat.h>
+#include <retro_dirent.h>
+#include <rthreads/rthreads.h>
+#include <features/features_cpu.h>
+
 #include "utils/bits.h"
 #include "MMU.h"
 #include "NDSSystem.h"
@@ -38,6 +53,81 @@ GPU3DInterface gpu3DNull = {
 GPU3DInterface *gpu3D = &gpu3DNull;
 Render3D *BaseRenderer = NULL;
 Render3D *CurrentRenderer = NULL;
+TextureUpscaleDiskCache textureUpscaleDiskCache;
+
+// Upscale cache files are a TextureUpscaleDiskCacheHeader padded out to
+// TEXTURE_UPSCALE_DISK_CACHE_HEADER_SIZE bytes, followed by the upscaled texels in
+// host byte order. The magic value doubles as a byte order check.
+#define TEXTURE_UPSCALE_DISK_CACHE_MAGIC		0x31435444 // "DTC1"
+#define TEXTURE_UPSCALE_DISK_CACHE_HEADER_SIZE	64
+
+struct TextureUpscaleDiskCacheHeader
+{
+	u32 magic;
+	u32 headerSize;
+	u32 width;
+	u32 height;
+	u64 key;
+};
+
+// MurmurHash64A, chained through the seed so that several buffers can go into one key.
+static u64 __TextureUpscaleCacheHash(const u8 *data, const size_t size, u64 seed)
+{
+	static const u64 m = 0xC6A4A7935BD1E995ULL;
+	static const int r = 47;
+	
+	u64 h = seed ^ ((u64)size * m);
+	const size_t wordCount = size / sizeof(u64);
+	
+	for (size_t i = 0; i < wordCount; i++)
+	{
+		u64 k;
+		memcpy(&k, data + (i * sizeof(u64)), sizeof(u64));
+		
+		k *= m;
+		k ^= k >> r;
+		k *= m;
+		
+		h ^= k;
+		h *= m;
+	}
+	
+	const u8 *tail = data + (wordCount * sizeof(u64));
+	const size_t tailSize = size & (sizeof(u64) - 1);
+	
+	if (tailSize > 0)
+	{
+		for (size_t i = 0; i < tailSize; i++)
+		{
+			h ^= (u64)tail[i] << (i * 8);
+		}
+		
+		h *= m;
+	}
+	
+	h ^= h >> r;
+	h *= m;
+	h ^= h >> r;
+	
+	return h;
+}
+
+static bool __TextureUpscaleDiskCacheIsHeaderValid(const u8 *headerData, const u64 key, const size_t width, const size_t height)
+{
+	TextureUpscaleDiskCacheHeader header;
+	memcpy(&header, headerData, sizeof(header));
+	
+	if ( (header.magic != TEXTURE_UPSCALE_DISK_CACHE_MAGIC) ||
+	     (header.headerSize != TEXTURE_UPSCALE_DISK_CACHE_HEADER_SIZE) ||
+	     (header.width != width) ||
+	     (header.height != height) ||
+	     (header.key != key) )
+	{
+		return false;
+	}
+	
+	return true;
+}
 
 void Render3D_Init()
 {
@@ -174,8 +264,295 @@ void Render3DTexture::SetScalingFactor(size_t scalingFactor)
 	this->_scalingFactor = ( (scalingFactor == 2) || (scalingFactor == 4) ) ? scalingFactor : 1;
 }
 
+template <size_t SCALEFACTOR>
+void Render3DTexture::_UpscaleUsingCache(const u32 *__restrict src, u32 *__restrict dst)
+{
+	if (!this->_ReadUpscaleCache(SCALEFACTOR, dst))
+	{
+		this->_Upscale<SCALEFACTOR>(src, dst);
+		this->_WriteUpscaleCache(SCALEFACTOR, dst);
+	}
+}
+
+u64 Render3DTexture::_GetUpscaleCacheKey(const size_t scalingFactor) const
+{
+	// The packed texels, the 4x4 index data and the palette all sit back to back in _packData.
+	u64 key = __TextureUpscaleCacheHash(this->_packData, this->_packSize + this->_packIndexSize + this->_paletteSize, 0);
+	
+	// Except for 4x4 textures, whose _paletteSize is 0: NDSTextureUnpack4x4() reads their palette
+	// straight from VRAM, four colors at the offset in each block's index. Hash those colors too,
+	// or else textures that only differ by their palette would share a key.
+	if (this->_packFormat == TEXMODE_4X4)
+	{
+		const u16 *indexData = (const u16 *)this->_packIndexData;
+		const size_t blockCount = std::min<size_t>(this->_packIndexSize / sizeof(u16), (this->_sizeS >> 2) * (this->_sizeT >> 2));
+		
+		for (size_t i = 0; i < blockCount; i++)
+		{
+			u16 blockPalette[4];
+			const u32 palOffset = (LE_TO_LOCAL_16(indexData[i]) & 0x3FFF) << 2;
+			
+			for (size_t j = 0; j < 4; j++)
+			{
+				const u32 palAddress = this->_paletteAddress + palOffset + (u32)(j * sizeof(u16));
+				blockPalette[j] = *(u16 *)( MMU.texInfo.texPalSlot[(palAddress >> 14) & 0x7] + (palAddress & 0x3FFF) );
+			}
+			
+			key = __TextureUpscaleCacheHash((const u8 *)blockPalette, sizeof(blockPalette), key);
+		}
+	}
+	
+	// Mix in everything else that changes the unpacked result or the filters applied to it.
+	// The VRAM addresses are deliberately left out, since the same texture can be found at
+	// different addresses from one session to the next.
+	const u32 unpackAttributes[6] = {
+		(u32)this->_packFormat,
+		(u32)this->_sizeS,
+		(u32)this->_sizeT,
+		(u32)((this->_isPalZeroTransparent) ? 1 : 0),
+		(u32)((this->_useDeposterize) ? 1 : 0),
+		(u32)scalingFactor
+	};
+	
+	return __TextureUpscaleCacheHash((const u8 *)unpackAttributes, sizeof(unpackAttributes), key);
+}
+
+bool Render3DTexture::_ReadUpscaleCache(const size_t scalingFactor, u32 *__restrict dst) const
+{
+	if ( (scalingFactor == 1) || !textureUpscaleDiskCache.IsEnabled() )
+	{
+		return false;
+	}
+	
+	return textureUpscaleDiskCache.Read(this->_GetUpscaleCacheKey(scalingFactor), this->_sizeS * scalingFactor, this->_sizeT * scalingFactor, dst);
+}
+
+void Render3DTexture::_WriteUpscaleCache(const size_t scalingFactor, const u32 *__restrict src) const
+{
+	if ( (scalingFactor == 1) || !textureUpscaleDiskCache.IsEnabled() )
+	{
+		return;
+	}
+	
+	textureUpscaleDiskCache.Write(this->_GetUpscaleCacheKey(scalingFactor), this->_sizeS * scalingFactor, this->_sizeT * scalingFactor, src);
+}
+
 template void Render3DTexture::_Upscale<2>(const u32 *__restrict src, u32 *__restrict dst);
 template void Render3DTexture::_Upscale<4>(const u32 *__restrict src, u32 *__restrict dst);
+template void Render3DTexture::_UpscaleUsingCache<2>(const u32 *__restrict src, u32 *__restrict dst);
+template void Render3DTexture::_UpscaleUsingCache<4>(const u32 *__restrict src, u32 *__restrict dst);
+
+TextureUpscaleDiskCache::TextureUpscaleDiskCache()
+{
+	_requestedDirectoryPath.clear();
+	_directoryPath.clear();
+	_storedKeysLock = slock_new();
+}
+
+TextureUpscaleDiskCache::~TextureUpscaleDiskCache()
+{
+	slock_free(this->_storedKeysLock);
+}
+
+std::string TextureUpscaleDiskCache::_GetFilePath(const u64 key) const
+{
+	char fileName[32];
+	snprintf(fileName, sizeof(fileName), "%08X%08X.dtc", (unsigned int)(key >> 32), (unsigned int)(key & 0xFFFFFFFF));
+	
+	return this->_directoryPath + path_default_slash() + fileName;
+}
+
+void TextureUpscaleDiskCache::_ScanDirectory()
+{
+	slock_lock(this->_storedKeysLock);
+	this->_storedKeys.clear();
+	
+	RDIR *rdir = retro_opendir(this->_directoryPath.c_str());
+	if ( (rdir != NULL) && !retro_dirent_error(rdir) )
+	{
+		while (retro_readdir(rdir))
+		{
+			// Only names of the form written by _GetFilePath(): 16 hex digits and ".dtc".
+			const char *fileName = retro_dirent_get_name(rdir);
+			if ( (strlen(fileName) != 20) || (strcmp(fileName + 16, ".dtc") != 0) )
+			{
+				continue;
+			}
+			
+			char *keyEnd = NULL;
+			const u64 key = (u64)strtoull(fileName, &keyEnd, 16);
+			if (keyEnd == (fileName + 16))
+			{
+				this->_storedKeys.insert(key);
+			}
+		}
+	}
+	
+	if (rdir != NULL)
+	{
+		retro_closedir(rdir);
+	}
+	
+	slock_unlock(this->_storedKeysLock);
+}
+
+bool TextureUpscaleDiskCache::_IsKeyStored(const u64 key) const
+{
+	slock_lock(this->_storedKeysLock);
+	const bool isStored = (this->_storedKeys.find(key) != this->_storedKeys.end());
+	slock_unlock(this->_storedKeysLock);
+	
+	return isStored;
+}
+
+void TextureUpscaleDiskCache::_SetKeyStored(const u64 key, const bool isStored)
+{
+	slock_lock(this->_storedKeysLock);
+	if (isStored)
+	{
+		this->_storedKeys.insert(key);
+	}
+	else
+	{
+		this->_storedKeys.erase(key);
+	}
+	slock_unlock(this->_storedKeysLock);
+}
+
+bool TextureUpscaleDiskCache::IsEnabled() const
+{
+	return !this->_directoryPath.empty();
+}
+
+const std::string& TextureUpscaleDiskCache::GetDirectoryPath() const
+{
+	return this->_directoryPath;
+}
+
+void TextureUpscaleDiskCache::SetDirectoryPath(const char *directoryPath)
+{
+	if (directoryPath == NULL)
+	{
+		directoryPath = "";
+	}
+	
+	// Only try setting up the directory when the path actually changes, so that a
+	// directory that can't be created doesn't get retried on every frame.
+	if (this->_requestedDirectoryPath == directoryPath)
+	{
+		return;
+	}
+	
+	this->_requestedDirectoryPath = directoryPath;
+	this->_directoryPath.clear();
+	
+	if (directoryPath[0] == '\0')
+	{
+		return;
+	}
+	
+	if (!path_is_directory(directoryPath) && !path_mkdir(directoryPath))
+	{
+		printf("Render3D: Could not create the texture cache directory %s. The texture cache will not be used.\n", directoryPath);
+		return;
+	}
+	
+	this->_directoryPath = directoryPath;
+	this->_ScanDirectory();
+}
+
+bool TextureUpscaleDiskCache::Read(const u64 key, const size_t width, const size_t height, u32 *__restrict dst)
+{
+	if (!this->_IsKeyStored(key))
+	{
+		return false;
+	}
+	
+	const std::string filePath = this->_GetFilePath(key);
+	const size_t texelsSize = width * height * sizeof(u32);
+	u8 headerData[TEXTURE_UPSCALE_DISK_CACHE_HEADER_SIZE];
+	bool didRead = false;
+	
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		this->_SetKeyStored(key, false);
+		return didRead;
+	}
+	
+	DWORD headerBytesRead = 0;
+	DWORD texelBytesRead = 0;
+	didRead = ReadFile(file, headerData, sizeof(headerData), &headerBytesRead, NULL) && (headerBytesRead == sizeof(headerData)) &&
+	          __TextureUpscaleDiskCacheIsHeaderValid(headerData, key, width, height) &&
+	          ReadFile(file, dst, (DWORD)texelsSize, &texelBytesRead, NULL) && (texelBytesRead == texelsSize);
+	
+	CloseHandle(file);
+#else
+	const int fd = open(filePath.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		this->_SetKeyStored(key, false);
+		return didRead;
+	}
+	
+	didRead = (read(fd, headerData, sizeof(headerData)) == (ssize_t)sizeof(headerData)) &&
+	          __TextureUpscaleDiskCacheIsHeaderValid(headerData, key, width, height) &&
+	          (read(fd, dst, texelsSize) == (ssize_t)texelsSize);
+	
+	close(fd);
+#endif
+	
+	// A file that doesn't hold what its name says gets replaced by the next Write().
+	if (!didRead)
+	{
+		this->_SetKeyStored(key, false);
+	}
+	
+	return didRead;
+}
+
+void TextureUpscaleDiskCache::Write(const u64 key, const size_t width, const size_t height, const u32 *__restrict src)
+{
+	const std::string filePath = this->_GetFilePath(key);
+	
+	// Write to a temporary file first, and then rename it into place. This way, another
+	// instance reading the same cache directory never sees a partially written file.
+	char tempSuffix[32];
+	snprintf(tempSuffix, sizeof(tempSuffix), ".%08X.tmp", (unsigned int)( (u64)cpu_features_get_time_usec() ^ (u64)(uintptr_t)src ));
+	const std::string tempFilePath = filePath + tempSuffix;
+	
+	FILE *fp = fopen(tempFilePath.c_str(), "wb");
+	if (fp == NULL)
+	{
+		return;
+	}
+	
+	u8 headerData[TEXTURE_UPSCALE_DISK_CACHE_HEADER_SIZE];
+	memset(headerData, 0, sizeof(headerData));
+	
+	TextureUpscaleDiskCacheHeader header;
+	header.magic = TEXTURE_UPSCALE_DISK_CACHE_MAGIC;
+	header.headerSize = TEXTURE_UPSCALE_DISK_CACHE_HEADER_SIZE;
+	header.width = (u32)width;
+	header.height = (u32)height;
+	header.key = key;
+	memcpy(headerData, &header, sizeof(header));
+	
+	const size_t texelCount = width * height;
+	const bool didWrite = (fwrite(headerData, 1, sizeof(headerData), fp) == sizeof(headerData)) &&
+	                      (fwrite(src, sizeof(u32), texelCount, fp) == texelCount);
+	fclose(fp);
+	
+	// If the rename fails, then most likely another instance already stored this texture.
+	if ( !didWrite || (rename(tempFilePath.c_str(), filePath.c_str()) != 0) )
+	{
+		remove(tempFilePath.c_str());
+		return;
+	}
+	
+	this->_SetKeyStored(key, true);
+}
 
 void* Render3D::operator new(size_t size)
 {
@@ -432,6 +809,8 @@ Render3DError Render3D::ApplyRenderingSettings(const GFX3D_State &renderState)
 	this->_prevEnableTextureDeposterize = this->_enableTextureDeposterize;
 	this->_enableTextureDeposterize = CommonSettings.GFX3D_Renderer_TextureDeposterize;
 	
+	textureUpscaleDiskCache.SetDirectoryPath(CommonSettings.GFX3D_Renderer_TextureCachePath);
+	
 	this->_prevTextureScalingFactor = this->_textureScalingFactor;
 	size_t newScalingFactor = (size_t)CommonSettings.GFX3D_Renderer_TextureScalingFactor;
 	
@@ -19,11 +19,16 @@
 #ifndef RENDER3D_H
 #define RENDER3D_H
 
+#include <set>
+#include <string>
+
 #include "types.h"
 #include "gfx3d.h"
 #include "texcache.h"
 #include "./filter/filter.h"
 
+typedef struct slock slock_t;
+
 #define kUnsetTranslucentPolyID 255
 #define DEPTH_EQUALS_TEST_TOLERANCE 255
 
@@ -132,6 +137,11 @@ protected:
 	SSurface _deposterizeDstSurface;
 	
 	template<size_t SCALEFACTOR> void _Upscale(const u32 *__restrict src, u32 *__restrict dst);
+	template<size_t SCALEFACTOR> void _UpscaleUsingCache(const u32 *__restrict src, u32 *__restrict dst);
+	
+	u64 _GetUpscaleCacheKey(const size_t scalingFactor) const;
+	bool _ReadUpscaleCache(const size_t scalingFactor, u32 *__restrict dst) const;
+	void _WriteUpscaleCache(const size_t scalingFactor, const u32 *__restrict src) const;
 	
 public:
 	Render3DTexture(TEXIMAGE_PARAM texAttributes, u32 palAttributes);
@@ -146,6 +156,44 @@ public:
 	void SetScalingFactor(size_t scalingFactor);
 };
 
+// Keeps upscaled textures on disk so that later sessions, and other emulator instances
+// pointed at the same directory, don't need to run the xBRZ and deposterize filters again.
+// Files are named after a hash of the texture's packed data and palette, and hold the
+// 32-bit RGBA result directly after a fixed-size header so that they can be read straight
+// into the upscale buffer.
+//
+// Read() and Write() may be called from several rasterizer threads at once. The directory
+// may only be changed while no texture is being loaded.
+class TextureUpscaleDiskCache
+{
+protected:
+	std::string _requestedDirectoryPath;
+	std::string _directoryPath;
+	
+	// Keys that have a file in the directory, so that a miss doesn't need to touch the disk.
+	// Files written by other instances after the directory was set are not seen.
+	std::set<u64> _storedKeys;
+	slock_t *_storedKeysLock;
+	
+	std::string _GetFilePath(const u64 key) const;
+	void _ScanDirectory();
+	bool _IsKeyStored(const u64 key) const;
+	void _SetKeyStored(const u64 key, const bool isStored);
+	
+public:
+	TextureUpscaleDiskCache();
+	~TextureUpscaleDiskCache();
+	
+	bool IsEnabled() const;
+	const std::string& GetDirectoryPath() const;
+	void SetDirectoryPath(const char *directoryPath);
+	
+	bool Read(const u64 key, const size_t width, const size_t height, u32 *__restrict dst);
+	void Write(const u64 key, const size_t width, const size_t height, const u32 *__restrict src);
+};
+
+extern TextureUpscaleDiskCache textureUpscaleDiskCache;
+
 class Render3D
 {
 protected:
@@ -22,6 +22,7 @@
 #include <zlib.h>
 #endif
 #include <stack>
+#include <deque>
 #include <set>
 #include <stdio.h>
 #include <string.h>
@@ -54,6 +55,7 @@
 #include "wifi.h"
 
 #include "path.h"
+#include "utils/task.h"
 
 #ifdef HOST_WINDOWS
 #include "frontend/windows/main.h"
@@ -74,7 +76,7 @@ NDS_SLOT2_TYPE slot2Type = NDS_SLOT2_AUTO;
 
 savestates_t savestates[NB_STATES];
 
-#define SAVESTATE_VERSION       12
+#define SAVESTATE_VERSION       13 //13 added block compression
 static const char* magic = "DeSmuME SState\0";
 
 //a savestate chunk loader can set this if it wants to permit a silent failure (for compatibility)
@@ -1040,13 +1042,111 @@ static void savestate_WriteChunk(EMUFILE &os, int type, void (*saveproc)(EMUFILE
 */
 }
 
-static void writechunks(EMUFILE &os);
+static void writechunks(EMUFILE &os, bool snapshot = false);
+
+//-------------
+//block compression
+//-------------
+//the chunk stream is cut into blocks which are deflated independently, so that compressing and
+//decompressing can be spread over worker threads. such a state has SAVESTATE_BLOCKED in place of the
+//compressed length, then the block size, the block count, the compressed length of every block and
+//the blocks themselves. states compressed as a single stream still load. older versions of the emulator
+//would take SAVESTATE_BLOCKED for a single stream of that length, which is why it came with version 13.
+
+#define SAVESTATE_BLOCKED 0xFFFFFFFE
+#define SAVESTATE_BLOCK_SIZE (256*1024)
+#define SAVESTATE_MAX_THREADS 8
+
+struct SavestateBlock
+{
+	const u8 *src;
+	u32 srcLen;
+	u8 *dst;
+	u32 dstLen; //room in dst going in, the length produced coming out
+	int error;
+};
+
+struct SavestateBlockJob
+{
+	SavestateBlock *blocks;
+	size_t count;
+	size_t first;
+	size_t stride;
+	bool compress;
+	int level;
+};
+
+static Task *savestate_task = NULL;
+static size_t savestate_taskCount = 0;
+
+static void* savestate_blockworker(void *param)
+{
+	SavestateBlockJob *job = (SavestateBlockJob *)param;
+	for (size_t i = job->first; i < job->count; i += job->stride)
+	{
+		SavestateBlock &block = job->blocks[i];
+		uLongf outLen = block.dstLen;
+		if (job->compress)
+			block.error = compress2(block.dst, &outLen, block.src, block.srcLen, job->level);
+		else
+		{
+			block.error = uncompress(block.dst, &outLen, block.src, block.srcLen);
+			if (block.error == Z_OK && outLen != block.dstLen)
+				block.error = Z_DATA_ERROR;
+		}
+		block.dstLen = (u32)outLen;
+	}
+	return NULL;
+}
+
+//processes every block, on the calling thread and on as many workers as num_cores allows.
+//the workers are started the first time they're needed and kept for later states.
+static bool savestate_runblocks(SavestateBlock *blocks, const size_t count, const bool compress, const int level)
+{
+	if (savestate_task == NULL && CommonSettings.num_cores > 1)
+	{
+		savestate_taskCount = std::min<size_t>(CommonSettings.num_cores, SAVESTATE_MAX_THREADS) - 1;
+		savestate_task = new Task[savestate_taskCount];
+		for (size_t i = 0; i < savestate_taskCount; i++)
+		{
+			char name[16];
+			snprintf(name, 16, "savestate %d", (int)i);
+			savestate_task[i].start(false, 0, name);
+		}
+	}
+
+	const size_t threadCount = std::min<size_t>(savestate_taskCount + 1, count);
+	SavestateBlockJob job[SAVESTATE_MAX_THREADS];
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		job[i].blocks = blocks;
+		job[i].count = count;
+		job[i].first = i;
+		job[i].stride = threadCount;
+		job[i].compress = compress;
+		job[i].level = level;
+	}
+
+	for (size_t i = 1; i < threadCount; i++)
+		savestate_task[i - 1].execute(&savestate_blockworker, &job[i]);
+	savestate_blockworker(&job[0]);
+	for (size_t i = 1; i < threadCount; i++)
+		savestate_task[i - 1].finish();
+
+	for (size_t i = 0; i < count; i++)
+	{
+		if (blocks[i].error != Z_OK)
+			return false;
+	}
+	return true;
+}
 
 bool savestate_save(EMUFILE &outstream, int compressionLevel)
 {
 #ifdef HAVE_JIT 
 	arm_jit_sync();
 #endif
+	GPU->FinishDeferredLineRender();
 	#ifndef HAVE_LIBZ
 	compressionLevel = Z_NO_COMPRESSION;
 	#endif
@@ -1065,22 +1165,26 @@ bool savestate_save(EMUFILE &outstream, int compressionLevel)
 	u32 len = os.ftell();
 
 	u32 comprlen = 0xFFFFFFFF;
-	u8* cbuf;
 
 	//compress the data
-	int error = Z_OK;
+	bool ok = true;
+	const u32 blockCount = (len + SAVESTATE_BLOCK_SIZE - 1) / SAVESTATE_BLOCK_SIZE;
+	const u32 blockBound = (u32)compressBound(SAVESTATE_BLOCK_SIZE);
+	std::vector<SavestateBlock> blocks;
+	std::vector<u8> cbuf;
 	if (compressionLevel != Z_NO_COMPRESSION)
 	{
-		cbuf = ms.buf();
-		uLongf comprlen2;
-		//worst case compression.
-		//zlib says "0.1% larger than sourceLen plus 12 bytes"
-		comprlen = (len>>9)+12 + len;
-		cbuf = new u8[comprlen];
-		// Workaround to make it compile under linux 64bit
-		comprlen2 = comprlen;
-		error = compress2(cbuf,&comprlen2,ms.buf(),len,compressionLevel);
-		comprlen = (u32)comprlen2;
+		blocks.resize(blockCount);
+		cbuf.resize((size_t)blockCount * blockBound);
+		for (u32 i = 0; i < blockCount; i++)
+		{
+			blocks[i].src = ms.buf() + i * SAVESTATE_BLOCK_SIZE;
+			blocks[i].srcLen = std::min<u32>(SAVESTATE_BLOCK_SIZE, len - i * SAVESTATE_BLOCK_SIZE);
+			blocks[i].dst = &cbuf[(size_t)i * blockBound];
+			blocks[i].dstLen = blockBound;
+		}
+		ok = savestate_runblocks(&blocks[0], blockCount, true, compressionLevel);
+		comprlen = SAVESTATE_BLOCKED;
 	}
 
 	//dump the header
@@ -1093,17 +1197,21 @@ bool savestate_save(EMUFILE &outstream, int compressionLevel)
 
 	if (compressionLevel != Z_NO_COMPRESSION)
 	{
-		outstream.fwrite(cbuf,comprlen==(u32)-1?len:comprlen);
-		delete[] cbuf;
+		outstream.write_32LE(SAVESTATE_BLOCK_SIZE);
+		outstream.write_32LE(blockCount);
+		for (u32 i = 0; i < blockCount; i++)
+			outstream.write_32LE(blocks[i].dstLen);
+		for (u32 i = 0; i < blockCount; i++)
+			outstream.fwrite(blocks[i].dst, blocks[i].dstLen);
 	}
 
-	return error == Z_OK;
+	return ok;
 }
 
 bool savestate_save (const char *file_name)
 {
 	EMUFILE_MEMORY ms;
-	if (!savestate_save(ms))
+	if (!savestate_save(ms, CommonSettings.savestate_compression))
 		return false;
 
 	EMUFILE_FILE file(file_name, "wb");
@@ -1119,7 +1227,8 @@ static void wifi_savestate(EMUFILE &os)
 	wifiHandler->SaveState(os);
 }
 
-static void writechunks(EMUFILE &os)
+//snapshots leave out the SF_MEM blocks, which they copy separately, and the game info, which they don't need
+static void writechunks(EMUFILE &os, bool snapshot)
 {
 
 	DateTime tm = DateTime::get_Now();
@@ -1132,7 +1241,8 @@ static void writechunks(EMUFILE &os)
 	savestate_WriteChunk(os,1,SF_ARM9);
 	savestate_WriteChunk(os,2,SF_ARM7);
 	savestate_WriteChunk(os,3,cp15_savestate);
-	savestate_WriteChunk(os,4,SF_MEM);
+	if (!snapshot)
+		savestate_WriteChunk(os,4,SF_MEM);
 	savestate_WriteChunk(os,5,SF_NDS);
 	savestate_WriteChunk(os,51,nds_savestate);
 	savestate_WriteChunk(os,60,SF_MMU);
@@ -1146,7 +1256,8 @@ static void writechunks(EMUFILE &os)
 	savestate_WriteChunk(os,101,mov_savestate);
 	savestate_WriteChunk(os,111,&wifi_savestate);
 	savestate_WriteChunk(os,120,SF_RTC);
-	savestate_WriteChunk(os,130,SF_NDS_INFO);
+	if (!snapshot)
+		savestate_WriteChunk(os,130,SF_NDS_INFO);
 	savestate_WriteChunk(os,140,s_slot1_savestate);
 	savestate_WriteChunk(os,150,s_slot2_savestate);
 	// reserved for future versions
@@ -1290,6 +1401,10 @@ static void loadstate()
     for (int i = 0; i < 0xA; i++)
        _MMU_write08<ARMCPU_ARM9>(0x04000240+i, _MMU_read08<ARMCPU_ARM9>(0x04000240+i));
 
+	// The whole LCDC buffer was replaced, so anything tracking VRAM writes needs to recheck it
+	MMU_VRAMMarkAllDirty();
+	MMU_SnapshotMarkAllDirty();
+
     // This should regenerate the graphics power control register
     _MMU_write16<ARMCPU_ARM9>(0x04000304, _MMU_read16<ARMCPU_ARM9>(0x04000304));
 
@@ -1317,6 +1432,7 @@ static void loadstate()
 bool savestate_load(EMUFILE &is)
 {
 	SAV_silent_fail_flag = false;
+	GPU->FinishDeferredLineRender();
 	char header[16];
 	is.fread(header,16);
 	if (is.fail() || memcmp(header,magic,16))
@@ -1328,11 +1444,53 @@ bool savestate_load(EMUFILE &is)
 	if (!is.read_32LE(len)) return false;
 	if (!is.read_32LE(comprlen)) return false;
 
-	if (ssversion != SAVESTATE_VERSION) return false;
+	//version 12 is the same apart from not knowing block compression
+	if (ssversion != SAVESTATE_VERSION && ssversion != 12) return false;
 
 	std::vector<u8> buf(len);
 
-	if (comprlen != 0xFFFFFFFF)
+	if (comprlen == SAVESTATE_BLOCKED)
+	{
+		if (ssversion < 13) return false;
+
+#ifndef HAVE_LIBZ
+		//without libz, we can't decompress this savestate
+		return false;
+#else
+		u32 blockSize, blockCount;
+		if (!is.read_32LE(blockSize)) return false;
+		if (!is.read_32LE(blockCount)) return false;
+		if (blockSize == 0 || len == 0 || blockCount != (len - 1) / blockSize + 1) return false;
+
+		std::vector<SavestateBlock> blocks(blockCount);
+		size_t total = 0;
+		for (u32 i = 0; i < blockCount; i++)
+		{
+			if (!is.read_32LE(blocks[i].srcLen)) return false;
+			total += blocks[i].srcLen;
+		}
+
+		//every block deflates to at least a couple of bytes, so a state with no data at all is broken
+		if (total == 0) return false;
+
+		std::vector<u8> cbuf(total);
+		is.fread(&cbuf[0], total);
+		if (is.fail()) return false;
+
+		size_t ofs = 0;
+		for (u32 i = 0; i < blockCount; i++)
+		{
+			blocks[i].src = &cbuf[0] + ofs;
+			blocks[i].dst = &buf[0] + (size_t)i * blockSize;
+			blocks[i].dstLen = std::min<u32>(blockSize, len - i * blockSize);
+			ofs += blocks[i].srcLen;
+		}
+
+		if (!savestate_runblocks(&blocks[0], blockCount, false, 0))
+			return false;
+#endif
+	}
+	else if (comprlen != 0xFFFFFFFF)
 	{
 #ifndef HAVE_LIBZ
 		//without libz, we can't decompress this savestate
@@ -1407,3 +1565,425 @@ bool savestate_load(const char *file_name)
 
 	return savestate_load(f);
 }
+
+//-------------
+//snapshots
+//-------------
+//a snapshot keeps the SF_MEM blocks as a straight copy and the remaining chunks in savestate format.
+//both buffers are kept between takes, so after the first take nothing gets reallocated.
+//restoring reads the chunks over the running emulator instead of starting from NDS_Reset() like
+//savestate_load() does, which is what keeps it fast, but it means a snapshot is only good for the
+//session and the ROM it was taken in.
+//
+//the MMU keeps dirty bits for the pages of main RAM and the LCDC buffer, which are cleared whenever a
+//full snapshot is taken or restored. an incremental snapshot copies only the pages that are dirty
+//relative to such a base, plus the small blocks, and a restore skips the compare for every page
+//the bits say still matches the base.
+
+#define SNAPSHOT_PAGE_SIZE (1 << MMU_SNAPSHOT_PAGE_SHIFT)
+
+struct savestate_snapshot
+{
+	std::vector<u8> mem;
+	std::vector<u8> chunks;
+	u32 chunksSize;
+
+	//for an incremental snapshot, the offsets (within a full snapshot's mem) of the pages it holds.
+	//mem has the untracked blocks whole and then just those pages; everything else comes from base.
+	savestate_snapshot *base;
+	std::vector<u32> pages;
+};
+
+//the full snapshot that the MMU's snapshot dirty bits are relative to
+static savestate_snapshot *snapshot_tracked = NULL;
+
+//returns the snapshot dirty map covering an SF_MEM block and the index of the block's first page in it,
+//or NULL for the small blocks which are always copied whole
+static u32* snapshot_dirtymap(const SFORMAT *sf, u32 &firstPage)
+{
+	const u8 *v = (const u8 *)sf->v;
+	if (v >= MMU.MAIN_MEM && v < MMU.MAIN_MEM + sizeof(MMU.MAIN_MEM))
+	{
+		firstPage = (u32)((v - MMU.MAIN_MEM) >> MMU_SNAPSHOT_PAGE_SHIFT);
+		return mmu_snapshot_main_dirty;
+	}
+	if (v == MMU.ARM9_LCD)
+	{
+		firstPage = 0;
+		return mmu_snapshot_vram_dirty;
+	}
+	return NULL;
+}
+
+static inline bool snapshot_pagedirty(const u32 *map, const u32 page)
+{
+	return (map[page >> 5] & (1 << (page & 31))) != 0;
+}
+
+//sets the dirty bits for the pages an incremental snapshot holds, which differ from its base
+static void snapshot_markpages(const savestate_snapshot *snap)
+{
+	size_t next = 0;
+	u32 layoutOfs = 0;
+	for (const SFORMAT *sf = SF_MEM; sf->v && next < snap->pages.size(); sf++)
+	{
+		const u32 len = sf->size * sf->count;
+		u32 firstPage = 0;
+		u32 *map = snapshot_dirtymap(sf, firstPage);
+		while (map && next < snap->pages.size() && snap->pages[next] < layoutOfs + len)
+		{
+			const u32 page = firstPage + ((snap->pages[next] - layoutOfs) >> MMU_SNAPSHOT_PAGE_SHIFT);
+			map[page >> 5] |= (1 << (page & 31));
+			next++;
+		}
+		layoutOfs += len;
+	}
+}
+
+savestate_snapshot* snapshot_create()
+{
+	savestate_snapshot *snap = new savestate_snapshot();
+	snap->chunksSize = 0;
+	snap->base = NULL;
+	return snap;
+}
+
+void snapshot_destroy(savestate_snapshot *snap)
+{
+	if (snapshot_tracked == snap)
+		snapshot_tracked = NULL;
+	delete snap;
+}
+
+//copies the whole state into snap, leaving the dirty bits and the tracked snapshot alone
+static bool snapshot_capture(savestate_snapshot *snap)
+{
+#ifdef HAVE_JIT
+	arm_jit_sync();
+#endif
+	GPU->FinishDeferredLineRender();
+
+	size_t memSize = 0;
+	for (const SFORMAT *sf = SF_MEM; sf->v; sf++)
+		memSize += sf->size * sf->count;
+	snap->mem.resize(memSize);
+
+	u8 *dst = &snap->mem[0];
+	for (const SFORMAT *sf = SF_MEM; sf->v; sf++)
+	{
+		memcpy(dst, sf->v, sf->size * sf->count);
+		dst += sf->size * sf->count;
+	}
+
+	EMUFILE_MEMORY os(&snap->chunks);
+	writechunks(os, true);
+	snap->chunksSize = os.ftell();
+
+	snap->base = NULL;
+	snap->pages.clear();
+
+	return !os.fail();
+}
+
+bool snapshot_take(savestate_snapshot *snap)
+{
+	const bool ok = snapshot_capture(snap);
+	MMU_SnapshotClearDirty();
+	snapshot_tracked = snap;
+
+	return ok;
+}
+
+bool snapshot_take_incremental(savestate_snapshot *snap, savestate_snapshot *base)
+{
+	//the dirty bits only tell what changed since the last full snapshot taken or restored
+	if (base == snap || base != snapshot_tracked || base->base != NULL)
+		return false;
+
+#ifdef HAVE_JIT
+	arm_jit_sync();
+#endif
+	GPU->FinishDeferredLineRender();
+
+	snap->base = base;
+	snap->pages.clear();
+	snap->mem.clear();
+
+	u32 layoutOfs = 0;
+	for (const SFORMAT *sf = SF_MEM; sf->v; sf++)
+	{
+		const u8 *src = (const u8 *)sf->v;
+		const u32 len = sf->size * sf->count;
+		u32 firstPage = 0;
+		const u32 *map = snapshot_dirtymap(sf, firstPage);
+
+		if (map == NULL)
+			snap->mem.insert(snap->mem.end(), src, src + len);
+		else
+		{
+			for (u32 ofs = 0; ofs < len; ofs += SNAPSHOT_PAGE_SIZE)
+			{
+				if (!snapshot_pagedirty(map, firstPage + (ofs >> MMU_SNAPSHOT_PAGE_SHIFT)))
+					continue;
+				snap->pages.push_back(layoutOfs + ofs);
+				snap->mem.insert(snap->mem.end(), src + ofs, src + ofs + SNAPSHOT_PAGE_SIZE);
+			}
+		}
+		layoutOfs += len;
+	}
+
+	EMUFILE_MEMORY os(&snap->chunks);
+	writechunks(os, true);
+	snap->chunksSize = os.ftell();
+
+	return !os.fail();
+}
+
+bool snapshot_restore(savestate_snapshot *snap)
+{
+	savestate_snapshot *base = snap->base ? snap->base : snap;
+	if (snap->chunksSize == 0 || base->chunksSize == 0)
+		return false;
+
+	SAV_silent_fail_flag = false;
+	GPU->FinishDeferredLineRender();
+
+	//a tracked page which hasn't been written since the base was taken still holds the base's data,
+	//and any other page is only rewritten if it changed; a page that was left alone costs just the compare
+	const bool tracked = (base == snapshot_tracked);
+	const u8 *inc = snap->mem.empty() ? NULL : &snap->mem[0];
+	size_t next = 0;
+	u32 layoutOfs = 0;
+	for (const SFORMAT *sf = SF_MEM; sf->v; sf++)
+	{
+		u8 *dst = (u8 *)sf->v;
+		const u32 len = sf->size * sf->count;
+		u32 firstPage = 0;
+		const u32 *map = snapshot_dirtymap(sf, firstPage);
+
+		for (u32 ofs = 0; ofs < len; ofs += SNAPSHOT_PAGE_SIZE)
+		{
+			const u32 pageLen = std::min<u32>(SNAPSHOT_PAGE_SIZE, len - ofs);
+			const u8 *src;
+			if (snap->base != NULL && (map == NULL || (next < snap->pages.size() && snap->pages[next] == layoutOfs + ofs)))
+			{
+				src = inc;
+				inc += pageLen;
+				if (map != NULL)
+					next++;
+			}
+			else if (tracked && map != NULL && !snapshot_pagedirty(map, firstPage + (ofs >> MMU_SNAPSHOT_PAGE_SHIFT)))
+				continue;
+			else
+				src = &base->mem[layoutOfs + ofs];
+
+			if (memcmp(dst + ofs, src, pageLen) != 0)
+			{
+				memcpy(dst + ofs, src, pageLen);
+				//bumps the page's write generation for the cached interpreter; the dirty bits are reset below
+				if (map == mmu_snapshot_main_dirty)
+					MMU_MainMemMarkDirtyRange((u32)(dst + ofs - MMU.MAIN_MEM), pageLen);
+#if defined(HAVE_JIT) && defined(MAPPED_JIT_FUNCS)
+				if (CommonSettings.use_jit)
+					arm_jit_invalidate(dst + ofs, pageLen);
+#endif
+			}
+		}
+		layoutOfs += len;
+	}
+
+	EMUFILE_MEMORY is(&snap->chunks);
+	if (!ReadStateChunks(is, (s32)snap->chunksSize))
+		return false;
+
+	loadstate();
+
+	//memory now matches the base apart from the pages an incremental snapshot brought in
+	MMU_SnapshotClearDirty();
+	snapshot_markpages(snap);
+	snapshot_tracked = base;
+
+	//the pages copied back above have already dropped their compiled code. the chunks also reload the
+	//smaller banks code can run from, which aren't tracked, so their compiled code is dropped whole.
+	//the flat table has a separate slot for every mirror of an address, so it is simply reset
+#ifdef HAVE_JIT
+	if (CommonSettings.use_jit)
+	{
+#ifdef MAPPED_JIT_FUNCS
+		arm_jit_invalidate(MMU.SWIRAM, sizeof(MMU.SWIRAM));
+		arm_jit_invalidate(MMU.ARM7_ERAM, sizeof(MMU.ARM7_ERAM));
+		arm_jit_invalidate(MMU.ARM7_WIRAM, sizeof(MMU.ARM7_WIRAM));
+#else
+		arm_jit_reset(true, true);
+#endif
+	}
+#endif
+
+	return true;
+}
+
+//-------------
+//rewind
+//-------------
+//states are captured as snapshots, so capturing and stepping back skip the reset and the chunk
+//bookkeeping of a full savestate. the newest state is kept whole. every older state is kept as the xor
+//of its memory blocks and its chunks with those of the state captured after it, encoded as runs of zero
+//words and literal words. consecutive frames differ in a small part of memory, so those deltas come out
+//small and cost a single pass to make and to undo.
+
+struct RewindState
+{
+	int frame; //currFrameCounter when the state was captured
+	u32 memSize, chunksSize; //sizes of the whole state's buffers
+	std::vector<u32> memDelta, chunksDelta; //(zero word count, literal word count, literal words...)*
+};
+
+static std::deque<RewindState> rewindDeltas;
+static savestate_snapshot rewindNewest;
+static savestate_snapshot rewindCapture; //the buffers for the next capture, reused from the last one
+static int rewindNewestFrame = 0;
+static int rewindInterval = 0;
+static int rewindCapacity = 0;
+static int rewindCounter = 0;
+
+static FORCEINLINE u32 rewind_word(const std::vector<u8> &state, size_t i)
+{
+	u32 w = 0;
+	if (i*4 + 4 <= state.size())
+		memcpy(&w, &state[i*4], 4);
+	else if (i*4 < state.size())
+		memcpy(&w, &state[i*4], state.size() - i*4);
+	return w;
+}
+
+static void rewind_encode(const std::vector<u8> &older, const std::vector<u8> &newer, std::vector<u32> &delta)
+{
+	const size_t words = (std::max(older.size(), newer.size()) + 3) / 4;
+	delta.clear();
+
+	size_t i = 0;
+	while (i < words)
+	{
+		const size_t zeroStart = i;
+		while (i < words && rewind_word(older, i) == rewind_word(newer, i))
+			i++;
+		const size_t literalStart = i;
+		while (i < words && rewind_word(older, i) != rewind_word(newer, i))
+			i++;
+
+		delta.push_back((u32)(literalStart - zeroStart));
+		delta.push_back((u32)(i - literalStart));
+		for (size_t j = literalStart; j < i; j++)
+			delta.push_back(rewind_word(older, j) ^ rewind_word(newer, j));
+	}
+}
+
+//turns a buffer of the state captured after a delta back into the delta's state
+static void rewind_decode(std::vector<u8> &state, const u32 size, const std::vector<u32> &delta)
+{
+	const size_t words = (std::max((size_t)size, state.size()) + 3) / 4;
+	state.resize(words*4, 0);
+
+	u8 *dst = &state[0];
+	size_t i = 0;
+	size_t pos = 0;
+	while (pos < delta.size())
+	{
+		i += delta[pos++];
+		for (u32 n = delta[pos++]; n > 0; n--, i++)
+		{
+			u32 w;
+			memcpy(&w, dst + i*4, 4);
+			w ^= delta[pos++];
+			memcpy(dst + i*4, &w, 4);
+		}
+	}
+
+	state.resize(size);
+}
+
+//the dirty bits can't vouch for rewindNewest once its contents are swapped out or decoded
+static void rewind_untrack()
+{
+	if (snapshot_tracked == &rewindNewest)
+		snapshot_tracked = NULL;
+}
+
+void rewind_setup(int interval, int capacity)
+{
+	rewind_clear();
+	rewindInterval = (capacity > 0) ? std::max(interval, 1) : 0;
+	rewindCapacity = std::max(capacity, 0);
+}
+
+void rewind_clear()
+{
+	rewind_untrack();
+	rewindDeltas.clear();
+	std::vector<u8>().swap(rewindNewest.mem);
+	std::vector<u8>().swap(rewindNewest.chunks);
+	rewindNewest.chunksSize = 0;
+	std::vector<u8>().swap(rewindCapture.mem);
+	std::vector<u8>().swap(rewindCapture.chunks);
+	rewindCapture.chunksSize = 0;
+	rewindNewestFrame = 0;
+	rewindCounter = 0;
+}
+
+int rewind_count()
+{
+	return (rewindNewest.chunksSize == 0) ? 0 : (int)rewindDeltas.size() + 1;
+}
+
+void rewind_frame()
+{
+	if (rewindInterval == 0 || ++rewindCounter < rewindInterval)
+		return;
+	rewindCounter = 0;
+
+	if (!snapshot_capture(&rewindCapture))
+		return;
+	rewindCapture.chunks.resize(rewindCapture.chunksSize);
+
+	if (rewindNewest.chunksSize != 0)
+	{
+		rewindDeltas.push_back(RewindState());
+		RewindState &rs = rewindDeltas.back();
+		rs.frame = rewindNewestFrame;
+		rs.memSize = (u32)rewindNewest.mem.size();
+		rs.chunksSize = rewindNewest.chunksSize;
+		rewind_encode(rewindNewest.mem, rewindCapture.mem, rs.memDelta);
+		rewind_encode(rewindNewest.chunks, rewindCapture.chunks, rs.chunksDelta);
+
+		while ((int)rewindDeltas.size() >= rewindCapacity)
+			rewindDeltas.pop_front();
+	}
+
+	rewind_untrack();
+	rewindNewest.mem.swap(rewindCapture.mem);
+	rewindNewest.chunks.swap(rewindCapture.chunks);
+	std::swap(rewindNewest.chunksSize, rewindCapture.chunksSize);
+	rewindNewestFrame = currFrameCounter;
+}
+
+bool rewind_step(int frames)
+{
+	if (rewindNewest.chunksSize == 0)
+		return false;
+
+	//drop every state newer than the requested frame, stopping at the oldest one still held
+	const int target = currFrameCounter - std::max(frames, 0);
+	while (rewindNewestFrame > target && !rewindDeltas.empty())
+	{
+		const RewindState &rs = rewindDeltas.back();
+		rewind_untrack();
+		rewind_decode(rewindNewest.mem, rs.memSize, rs.memDelta);
+		rewind_decode(rewindNewest.chunks, rs.chunksSize, rs.chunksDelta);
+		rewindNewest.chunksSize = rs.chunksSize;
+		rewindNewestFrame = rs.frame;
+		rewindDeltas.pop_back();
+	}
+
+	rewindCounter = 0;
+	return snapshot_restore(&rewindNewest);
+}
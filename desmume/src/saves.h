@@ -67,4 +67,32 @@ void loadstate_slot(int num);
 bool savestate_load(class EMUFILE &is);
 bool savestate_save(class EMUFILE &outstream, int compressionLevel = Z_DEFAULT_COMPRESSION);
 
+// In-memory snapshots: the large memory blocks are copied directly and the
+// rest is kept in savestate format, in buffers reused between takes. Restoring
+// skips the full reset of a savestate load, so a snapshot may only be restored
+// in the session and on the ROM it was taken in.
+// An incremental snapshot holds only the main RAM and VRAM pages written since
+// its base was taken and borrows the rest from it. The base must be the full
+// snapshot most recently taken or restored (directly or through one of its
+// incrementals), and has to outlive the incremental without being retaken.
+struct savestate_snapshot;
+savestate_snapshot* snapshot_create();
+void snapshot_destroy(savestate_snapshot *snap);
+bool snapshot_take(savestate_snapshot *snap);
+bool snapshot_take_incremental(savestate_snapshot *snap, savestate_snapshot *base);
+bool snapshot_restore(savestate_snapshot *snap);
+
+// Rewind buffer: every interval frames a state is captured into a ring holding
+// up to capacity states, all but the newest stored as deltas. A capacity of 0
+// disables it. States are captured and restored as snapshots (see above), and
+// the buffer is cleared when the ROM is closed or another NDSInstance is selected.
+void rewind_setup(int interval, int capacity);
+void rewind_clear();
+int rewind_count();
+// called once per emulated frame by NDS_exec()
+void rewind_frame();
+// loads the newest held state from at least the given number of frames ago
+// (or the oldest one held) and discards everything newer
+bool rewind_step(int frames = 1);
+
 #endif
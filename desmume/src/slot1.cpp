@@ -54,7 +54,7 @@ static void scanDir()
 	}
 
 	VFAT vfat;
-	if(vfat.build(slot1_R4_path_type?path.RomDirectory.c_str():fatDir.c_str(), 16))
+	if(vfat.build(slot1_R4_path_type?path.RomDirectory.c_str():fatDir.c_str(), 16, CommonSettings.fatDirLazy))
 	{
 		fatImage = vfat.detach();
 	}
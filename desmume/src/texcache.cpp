@@ -141,10 +141,20 @@ public:
 		}
 		return done;
 	}
+
+	//returns true if any part of this MemSpan was written since the VRAM dirty pages were last cleared
+	bool isVRAMDirty() const
+	{
+		for(int i=0;i<numItems;i++)
+		{
+			if(MMU_VRAMIsDirty(items[i].ptr, items[i].len)) return true;
+		}
+		return false;
+	}
 };
 
 //creates a MemSpan in texture memory
-static MemSpan MemSpan_TexMem(u32 ofs, u32 len) 
+static MemSpan MemSpan_TexMem(u32 ofs, u32 len, bool silent) 
 {
 	MemSpan ret;
 	ret.size = len;
@@ -160,7 +170,7 @@ static MemSpan MemSpan_TexMem(u32 ofs, u32 len)
 		currofs += curr.len;
 		u8* ptr = MMU.texInfo.textureSlotAddr[slot];
 		
-		if (ptr == MMU.blank_memory && !GPU->GetEngineMain()->IsMasterBrightMaxOrMin()) {
+		if (ptr == MMU.blank_memory && !GPU->GetEngineMain()->IsMasterBrightMaxOrMin() && !silent) {
 			PROGINFO("Tried to reference unmapped texture memory: slot %d\n",slot);
 		}
 		curr.ptr = ptr + curr.start;
@@ -199,6 +209,34 @@ static MemSpan MemSpan_TexPalette(u32 ofs, u32 len, bool silent)
 	return ret;
 }
 
+//returns a bitmask of the 128KB texture slots touched by a range of texture memory
+static u8 TexMemSlotMask(u32 ofs, u32 len)
+{
+	u8 mask = 0;
+	while(len) {
+		const u32 todo = min(len,0x20000-(ofs&0x1FFFF));
+		mask |= 1 << ((ofs>>17)&3);
+		len -= todo;
+		ofs += todo;
+	}
+	return mask;
+}
+
+//returns a bitmask of the 16KB texture palette slots touched by a range of texture palette memory
+static u8 TexPaletteSlotMask(u32 ofs, u32 len)
+{
+	u8 mask = 0;
+	while(len) {
+		const u32 todo = min(len,0x4000-(ofs&0x3FFF));
+		u32 slot = (ofs>>14)&7;
+		if(slot>5) slot -= 5; //wraps the same way as MemSpan_TexPalette
+		mask |= 1 << slot;
+		len -= todo;
+		ofs += todo;
+	}
+	return mask;
+}
+
 static bool TextureLRUCompare(TextureStore *tex1, TextureStore *tex2)
 {
 	const size_t cacheAge1 = tex1->GetCacheAge();
@@ -221,6 +259,7 @@ TextureCache::TextureCache()
 	_actualCacheSize = 0;
 	_cacheSizeThreshold = TEXCACHE_DEFAULT_THRESHOLD;
 	memset(_paletteDump, 0, sizeof(_paletteDump));
+	memset(_paletteDumpSlot, 0, sizeof(_paletteDumpSlot));
 }
 
 size_t TextureCache::GetActualCacheSize() const
@@ -240,19 +279,29 @@ void TextureCache::SetCacheSizeThreshold(size_t newThreshold)
 
 void TextureCache::Invalidate()
 {
-	//check whether the palette memory changed
-	//TODO - we should handle this instead by setting dirty flags in the vram memory mapping and noting whether palette memory was dirty.
-	//but this will work for now
+	//check whether the palette memory changed. this can only happen if a palette slot
+	//was remapped or if one of its pages was written since the last invalidation.
 	MemSpan mspal = MemSpan_TexPalette(0, PALETTE_DUMP_SIZE, true);
-	const bool paletteDirty = mspal.memcmp(this->_paletteDump);
-	if (paletteDirty)
+	bool paletteDirty = false;
+	
+	if ( memcmp(this->_paletteDumpSlot, MMU.texInfo.texPalSlot, sizeof(this->_paletteDumpSlot)) || mspal.isVRAMDirty() )
 	{
-		mspal.dump(this->_paletteDump);
+		memcpy(this->_paletteDumpSlot, MMU.texInfo.texPalSlot, sizeof(this->_paletteDumpSlot));
+		
+		paletteDirty = (mspal.memcmp(this->_paletteDump) != 0);
+		if (paletteDirty)
+		{
+			mspal.dump(this->_paletteDump);
+		}
 	}
 	
 	for (TextureCacheMap::iterator it(this->_texCacheMap.begin()); it != this->_texCacheMap.end(); ++it)
 	{
-		it->second->SetSuspectedInvalid();
+		// Only textures whose VRAM was remapped or written to need to be compared against VRAM.
+		if (it->second->IsVRAMSourceChanged())
+		{
+			it->second->SetSuspectedInvalid();
+		}
 		
 		//when the palette changes, we assume all 4x4 textures are dirty.
 		//this is because each 4x4 item doesnt carry along with it a copy of the entire palette, for verification
@@ -262,6 +311,8 @@ void TextureCache::Invalidate()
 			it->second->SetAssumedInvalid();
 		}
 	}
+	
+	MMU_VRAMClearDirty();
 }
 
 void TextureCache::Evict()
@@ -403,6 +454,11 @@ TextureStore::TextureStore()
 	
 	_packTotalSize = 0;
 	
+	memset(_vramTexSlot, 0, sizeof(_vramTexSlot));
+	memset(_vramTexPalSlot, 0, sizeof(_vramTexPalSlot));
+	_vramTexSlotMask = 0;
+	_vramTexPalSlotMask = 0;
+	
 	_suspectedInvalid = false;
 	_assumedInvalid = false;
 	_isLoadNeeded = false;
@@ -456,7 +512,7 @@ TextureStore::TextureStore(const TEXIMAGE_PARAM texAttributes, const u32 palAttr
 		_packIndexData = _packData + _packSize;
 		_paletteColorTable = (u16 *)(_packData + _packSize + _packIndexSize);
 		
-		MemSpan currentPackedTexIndexMS = MemSpan_TexMem(_packIndexAddress, _packIndexSize);
+		MemSpan currentPackedTexIndexMS = MemSpan_TexMem(_packIndexAddress, _packIndexSize, false);
 		currentPackedTexIndexMS.dump(_packIndexData, _packIndexSize);
 	}
 	else
@@ -489,10 +545,14 @@ TextureStore::TextureStore(const TEXIMAGE_PARAM texAttributes, const u32 palAttr
 		_paletteColorTable = NULL;
 	}
 	
-	MemSpan currentPackedTexDataMS = MemSpan_TexMem(_packAddress, _packSize);
+	MemSpan currentPackedTexDataMS = MemSpan_TexMem(_packAddress, _packSize, false);
 	currentPackedTexDataMS.dump(_packData);
 	_packSizeFirstSlot = currentPackedTexDataMS.items[0].len;
 	
+	_vramTexSlotMask = TexMemSlotMask(_packAddress, _packSize) | TexMemSlotMask(_packIndexAddress, _packIndexSize);
+	_vramTexPalSlotMask = TexPaletteSlotMask(_paletteAddress, _paletteSize);
+	_UpdateVRAMSource();
+	
 	_suspectedInvalid = false;
 	_assumedInvalid = false;
 	_isLoadNeeded = true;
@@ -755,19 +815,58 @@ void TextureStore::ResetCacheUsageCount()
 	this->_cacheUsageCount = 0;
 }
 
+void TextureStore::_UpdateVRAMSource()
+{
+	memcpy(this->_vramTexSlot, MMU.texInfo.textureSlotAddr, sizeof(this->_vramTexSlot));
+	memcpy(this->_vramTexPalSlot, MMU.texInfo.texPalSlot, sizeof(this->_vramTexPalSlot));
+}
+
+bool TextureStore::IsVRAMSourceChanged() const
+{
+	for (size_t i = 0; i < 4; i++)
+	{
+		if ( ((this->_vramTexSlotMask >> i) & 1) && (this->_vramTexSlot[i] != MMU.texInfo.textureSlotAddr[i]) )
+		{
+			return true;
+		}
+	}
+	
+	for (size_t i = 0; i < 6; i++)
+	{
+		if ( ((this->_vramTexPalSlotMask >> i) & 1) && (this->_vramTexPalSlot[i] != MMU.texInfo.texPalSlot[i]) )
+		{
+			return true;
+		}
+	}
+	
+	// The mapping is the same as when the texture was last read, so check for writes to its pages.
+	if (MemSpan_TexMem(this->_packAddress, this->_packSize, true).isVRAMDirty())
+	{
+		return true;
+	}
+	
+	if ( (this->_packFormat == TEXMODE_4X4) && MemSpan_TexMem(this->_packIndexAddress, this->_packIndexSize, true).isVRAMDirty() )
+	{
+		return true;
+	}
+	
+	return MemSpan_TexPalette(this->_paletteAddress, this->_paletteSize, true).isVRAMDirty();
+}
+
 void TextureStore::Update()
 {
 	MemSpan currentPaletteMS = MemSpan_TexPalette(this->_paletteAddress, this->_paletteSize, false);
-	MemSpan currentPackedTexDataMS = MemSpan_TexMem(this->_packAddress, this->_packSize);
+	MemSpan currentPackedTexDataMS = MemSpan_TexMem(this->_packAddress, this->_packSize, false);
 	MemSpan currentPackedTexIndexMS;
 	
 	if (this->_packFormat == TEXMODE_4X4)
 	{
-		currentPackedTexIndexMS = MemSpan_TexMem(this->_packIndexAddress, this->_packIndexSize);
+		currentPackedTexIndexMS = MemSpan_TexMem(this->_packIndexAddress, this->_packIndexSize, false);
 	}
 	
 	this->SetTextureData(currentPackedTexDataMS, currentPackedTexIndexMS);
 	this->SetTexturePalette(currentPaletteMS);
+	this->_UpdateVRAMSource();
 	
 	this->_assumedInvalid = false;
 	this->_suspectedInvalid = false;
@@ -777,7 +876,7 @@ void TextureStore::Update()
 void TextureStore::VRAMCompareAndUpdate()
 {
 	MemSpan currentPaletteMS = MemSpan_TexPalette(this->_paletteAddress, this->_paletteSize, false);
-	MemSpan currentPackedTexDataMS = MemSpan_TexMem(this->_packAddress, this->_packSize);
+	MemSpan currentPackedTexDataMS = MemSpan_TexMem(this->_packAddress, this->_packSize, false);
 	MemSpan currentPackedTexIndexMS;
 	
 	currentPackedTexDataMS.dump(this->_workingData);
@@ -785,7 +884,7 @@ void TextureStore::VRAMCompareAndUpdate()
 	
 	if (this->_packFormat == TEXMODE_4X4)
 	{
-		currentPackedTexIndexMS = MemSpan_TexMem(this->_packIndexAddress, this->_packIndexSize);
+		currentPackedTexIndexMS = MemSpan_TexMem(this->_packIndexAddress, this->_packIndexSize, false);
 		currentPackedTexIndexMS.dump(this->_workingData + this->_packSize);
 	}
 	
@@ -823,6 +922,8 @@ void TextureStore::VRAMCompareAndUpdate()
 		this->_isLoadNeeded = true;
 	}
 	
+	this->_UpdateVRAMSource();
+	
 	this->_assumedInvalid = false;
 	this->_suspectedInvalid = false;
 }
@@ -1388,27 +1489,204 @@ void NDSTextureUnpackI4(const size_t srcSize, const u8 *__restrict srcData, cons
 	}
 }
 
+#if defined(ENABLE_AVX2)
+
+template <TextureStoreUnpackFormat TEXCACHEFORMAT, bool ISPALZEROTRANSPARENT>
+void __NDSTextureUnpackI8_AVX2(const size_t texelCount, const u8 *__restrict srcData, const u16 *__restrict srcPal, u32 *__restrict dstBuffer)
+{
+	v256u32 convertedColor[2];
+	
+	// The 512 byte palette is far too big for a register-based table lookup, so we gather
+	// the colors from memory instead. Each gather reads 4 bytes per index, so we copy the
+	// palette to a padded buffer to keep the last entry from reading past the palette.
+	CACHE_ALIGN u16 pal16[256 + 16];
+	memcpy(pal16, srcPal, 256 * sizeof(u16));
+	memset(pal16 + 256, 0, 16 * sizeof(u16));
+	
+	for (size_t i = 0; i < texelCount; i+=(sizeof(v256u16)/sizeof(u16)), srcData+=(sizeof(v256u16)/sizeof(u16)), dstBuffer+=(sizeof(v256u16)/sizeof(u16)))
+	{
+		const v256u32 idx0 = _mm256_cvtepu8_epi32( _mm_loadl_epi64((v128u8 *)(srcData + 0)) );
+		const v256u32 idx1 = _mm256_cvtepu8_epi32( _mm_loadl_epi64((v128u8 *)(srcData + 8)) );
+		
+		const v256u32 palColor32_0 = _mm256_and_si256( _mm256_i32gather_epi32((const int *)pal16, idx0, 2), _mm256_set1_epi32(0x00007FFF) );
+		const v256u32 palColor32_1 = _mm256_and_si256( _mm256_i32gather_epi32((const int *)pal16, idx1, 2), _mm256_set1_epi32(0x00007FFF) );
+		const v256u16 palColor = _mm256_permute4x64_epi64( _mm256_packus_epi32(palColor32_0, palColor32_1), 0xD8 );
+		
+		if (TEXCACHEFORMAT == TexFormat_15bpp)
+		{
+			ColorspaceConvert555To6665Opaque_AVX2<false>(palColor, convertedColor[0], convertedColor[1]);
+		}
+		else
+		{
+			ColorspaceConvert555To8888Opaque_AVX2<false>(palColor, convertedColor[0], convertedColor[1]);
+		}
+		
+		// Set converted colors to 0 if the palette index is 0.
+		if (ISPALZEROTRANSPARENT)
+		{
+			convertedColor[0] = _mm256_andnot_si256( _mm256_cmpeq_epi32(idx0, _mm256_setzero_si256()), convertedColor[0] );
+			convertedColor[1] = _mm256_andnot_si256( _mm256_cmpeq_epi32(idx1, _mm256_setzero_si256()), convertedColor[1] );
+		}
+		
+		_mm256_store_si256((v256u32 *)dstBuffer + 0, convertedColor[0]);
+		_mm256_store_si256((v256u32 *)dstBuffer + 1, convertedColor[1]);
+	}
+}
+
+#endif
+
 template <TextureStoreUnpackFormat TEXCACHEFORMAT>
 void NDSTextureUnpackI8(const size_t srcSize, const u8 *__restrict srcData, const u16 *__restrict srcPal, const bool isPalZeroTransparent, u32 *__restrict dstBuffer)
 {
 	if (isPalZeroTransparent)
 	{
+#if defined(ENABLE_AVX2)
+		__NDSTextureUnpackI8_AVX2<TEXCACHEFORMAT, true>(srcSize, srcData, srcPal, dstBuffer);
+#else
 		for (size_t i = 0; i < srcSize; i++, srcData++)
 		{
 			const u8 idx = *srcData;
 			*dstBuffer++ = (idx == 0) ? 0 : LE_TO_LOCAL_32( CONVERT(srcPal[idx] & 0x7FFF) );
 		}
+#endif
 	}
 	else
 	{
+#if defined(ENABLE_AVX2)
+		__NDSTextureUnpackI8_AVX2<TEXCACHEFORMAT, false>(srcSize, srcData, srcPal, dstBuffer);
+#else
 		for (size_t i = 0; i < srcSize; i++, srcData++)
 		{
 			*dstBuffer++ = LE_TO_LOCAL_32( CONVERT(srcPal[*srcData] & 0x7FFF) );
 		}
+#endif
+	}
+}
+
+#if defined(ENABLE_AVX2)
+
+static FORCEINLINE v256u8 __NDSTextureLookupTable64_AVX2(const v256u8 *__restrict LUT, const v256u8 &idx)
+{
+	// vpshufb can only index 16 bytes, so look up each 16 byte quarter of the table and
+	// keep only the lanes whose index actually falls inside that quarter.
+	const v256u8 tableSelect = _mm256_and_si256( _mm256_srli_epi16(idx, 4), _mm256_set1_epi8(0x0F) );
+	v256u8 result =                   _mm256_and_si256( _mm256_shuffle_epi8(LUT[0], idx), _mm256_cmpeq_epi8(tableSelect, _mm256_setzero_si256()) );
+	result = _mm256_or_si256( result, _mm256_and_si256( _mm256_shuffle_epi8(LUT[1], idx), _mm256_cmpeq_epi8(tableSelect, _mm256_set1_epi8(1)) ) );
+	result = _mm256_or_si256( result, _mm256_and_si256( _mm256_shuffle_epi8(LUT[2], idx), _mm256_cmpeq_epi8(tableSelect, _mm256_set1_epi8(2)) ) );
+	result = _mm256_or_si256( result, _mm256_and_si256( _mm256_shuffle_epi8(LUT[3], idx), _mm256_cmpeq_epi8(tableSelect, _mm256_set1_epi8(3)) ) );
+	
+	return result;
+}
+
+template <TextureStoreUnpackFormat TEXCACHEFORMAT>
+void __NDSTextureUnpackA3I5_AVX2(const size_t texelCount, const u8 *__restrict srcData, const u16 *__restrict srcPal, u32 *__restrict dstBuffer)
+{
+	v256u32 convertedColor[4];
+	const v256u8 pal16_LUT[4] = {
+		_mm256_broadcastsi128_si256( _mm_loadu_si128((v128u8 *)srcPal + 0) ),
+		_mm256_broadcastsi128_si256( _mm_loadu_si128((v128u8 *)srcPal + 1) ),
+		_mm256_broadcastsi128_si256( _mm_loadu_si128((v128u8 *)srcPal + 2) ),
+		_mm256_broadcastsi128_si256( _mm_loadu_si128((v128u8 *)srcPal + 3) )
+	};
+	const v256u8 alpha_LUT = (TEXCACHEFORMAT == TexFormat_15bpp) ? _mm256_load_si256((v256u8 *)material_3bit_to_5bit) : _mm256_load_si256((v256u8 *)material_3bit_to_8bit);
+	
+	for (size_t i = 0; i < texelCount; i+=sizeof(v256u8), srcData+=sizeof(v256u8), dstBuffer+=sizeof(v256u32))
+	{
+		const v256u8 bits = _mm256_loadu_si256((v256u8 *)srcData);
+		
+		v256u8 idx = _mm256_slli_epi16( _mm256_and_si256(bits, _mm256_set1_epi8(0x1F)), 1 );
+		
+		idx = _mm256_permute4x64_epi64(idx, 0xD8);
+		const v256u8 idx0 = _mm256_add_epi8( _mm256_unpacklo_epi8(idx, idx), _mm256_set1_epi16(0x0100) );
+		const v256u8 idx1 = _mm256_add_epi8( _mm256_unpackhi_epi8(idx, idx), _mm256_set1_epi16(0x0100) );
+		
+		const v256u16 palColor0 = __NDSTextureLookupTable64_AVX2(pal16_LUT, idx0);
+		const v256u16 palColor1 = __NDSTextureLookupTable64_AVX2(pal16_LUT, idx1);
+		
+		v256u8 alpha = _mm256_shuffle_epi8( alpha_LUT, _mm256_and_si256(_mm256_srli_epi16(bits, 5), _mm256_set1_epi8(0x07)) );
+		alpha = _mm256_permute4x64_epi64(alpha, 0xD8);
+		const v256u16 alphaLo = _mm256_unpacklo_epi8(_mm256_setzero_si256(), alpha);
+		const v256u16 alphaHi = _mm256_unpackhi_epi8(_mm256_setzero_si256(), alpha);
+		
+		if (TEXCACHEFORMAT == TexFormat_15bpp)
+		{
+			ColorspaceConvert555To6665_AVX2<false>(palColor0, alphaLo, convertedColor[0], convertedColor[1]);
+			ColorspaceConvert555To6665_AVX2<false>(palColor1, alphaHi, convertedColor[2], convertedColor[3]);
+		}
+		else
+		{
+			ColorspaceConvert555To8888_AVX2<false>(palColor0, alphaLo, convertedColor[0], convertedColor[1]);
+			ColorspaceConvert555To8888_AVX2<false>(palColor1, alphaHi, convertedColor[2], convertedColor[3]);
+		}
+		
+		_mm256_store_si256((v256u32 *)dstBuffer + 0, convertedColor[0]);
+		_mm256_store_si256((v256u32 *)dstBuffer + 1, convertedColor[1]);
+		_mm256_store_si256((v256u32 *)dstBuffer + 2, convertedColor[2]);
+		_mm256_store_si256((v256u32 *)dstBuffer + 3, convertedColor[3]);
 	}
 }
 
-#if defined(ENABLE_NEON_A64)
+#elif defined(ENABLE_SSSE3)
+
+static FORCEINLINE v128u8 __NDSTextureLookupTable64_SSSE3(const v128u8 *__restrict LUT, const v128u8 &idx)
+{
+	// pshufb can only index 16 bytes, so look up each 16 byte quarter of the table and
+	// keep only the lanes whose index actually falls inside that quarter.
+	const v128u8 tableSelect = _mm_and_si128( _mm_srli_epi16(idx, 4), _mm_set1_epi8(0x0F) );
+	v128u8 result =                _mm_and_si128( _mm_shuffle_epi8(LUT[0], idx), _mm_cmpeq_epi8(tableSelect, _mm_setzero_si128()) );
+	result = _mm_or_si128( result, _mm_and_si128( _mm_shuffle_epi8(LUT[1], idx), _mm_cmpeq_epi8(tableSelect, _mm_set1_epi8(1)) ) );
+	result = _mm_or_si128( result, _mm_and_si128( _mm_shuffle_epi8(LUT[2], idx), _mm_cmpeq_epi8(tableSelect, _mm_set1_epi8(2)) ) );
+	result = _mm_or_si128( result, _mm_and_si128( _mm_shuffle_epi8(LUT[3], idx), _mm_cmpeq_epi8(tableSelect, _mm_set1_epi8(3)) ) );
+	
+	return result;
+}
+
+template <TextureStoreUnpackFormat TEXCACHEFORMAT>
+void __NDSTextureUnpackA3I5_SSSE3(const size_t texelCount, const u8 *__restrict srcData, const u16 *__restrict srcPal, u32 *__restrict dstBuffer)
+{
+	v128u32 convertedColor[4];
+	const v128u8 pal16_LUT[4] = {
+		_mm_loadu_si128((v128u8 *)srcPal + 0),
+		_mm_loadu_si128((v128u8 *)srcPal + 1),
+		_mm_loadu_si128((v128u8 *)srcPal + 2),
+		_mm_loadu_si128((v128u8 *)srcPal + 3)
+	};
+	const v128u8 alpha_LUT = (TEXCACHEFORMAT == TexFormat_15bpp) ? _mm_load_si128((v128u8 *)material_3bit_to_5bit) : _mm_load_si128((v128u8 *)material_3bit_to_8bit);
+	
+	for (size_t i = 0; i < texelCount; i+=sizeof(v128u8))
+	{
+		const v128u8 bits = _mm_loadu_si128((v128u8 *)(srcData+i));
+		
+		const v128u8 idx = _mm_slli_epi16( _mm_and_si128(bits, _mm_set1_epi8(0x1F)), 1 );
+		const v128u8 idx0 = _mm_add_epi8( _mm_unpacklo_epi8(idx, idx), _mm_set1_epi16(0x0100) );
+		const v128u8 idx1 = _mm_add_epi8( _mm_unpackhi_epi8(idx, idx), _mm_set1_epi16(0x0100) );
+		
+		const v128u16 palColor0 = __NDSTextureLookupTable64_SSSE3(pal16_LUT, idx0);
+		const v128u16 palColor1 = __NDSTextureLookupTable64_SSSE3(pal16_LUT, idx1);
+		
+		const v128u8 alpha = _mm_shuffle_epi8( alpha_LUT, _mm_and_si128(_mm_srli_epi16(bits, 5), _mm_set1_epi8(0x07)) );
+		const v128u16 alphaLo = _mm_unpacklo_epi8(_mm_setzero_si128(), alpha);
+		const v128u16 alphaHi = _mm_unpackhi_epi8(_mm_setzero_si128(), alpha);
+		
+		if (TEXCACHEFORMAT == TexFormat_15bpp)
+		{
+			ColorspaceConvert555To6665_SSE2<false>(palColor0, alphaLo, convertedColor[0], convertedColor[1]);
+			ColorspaceConvert555To6665_SSE2<false>(palColor1, alphaHi, convertedColor[2], convertedColor[3]);
+		}
+		else
+		{
+			ColorspaceConvert555To8888_SSE2<false>(palColor0, alphaLo, convertedColor[0], convertedColor[1]);
+			ColorspaceConvert555To8888_SSE2<false>(palColor1, alphaHi, convertedColor[2], convertedColor[3]);
+		}
+		
+		_mm_store_si128((v128u32 *)(dstBuffer + i) + 0, convertedColor[0]);
+		_mm_store_si128((v128u32 *)(dstBuffer + i) + 1, convertedColor[1]);
+		_mm_store_si128((v128u32 *)(dstBuffer + i) + 2, convertedColor[2]);
+		_mm_store_si128((v128u32 *)(dstBuffer + i) + 3, convertedColor[3]);
+	}
+}
+
+#elif defined(ENABLE_NEON_A64)
 
 template <TextureStoreUnpackFormat TEXCACHEFORMAT>
 void __NDSTextureUnpackA3I5_NEON(const size_t texelCount, const u8 *__restrict srcData, const u16 *__restrict srcPal, u32 *__restrict dstBuffer)
@@ -1509,7 +1787,14 @@ void NDSTextureUnpackA3I5(const size_t srcSize, const u8 *__restrict srcData, co
 {
 	const size_t texelCount = srcSize / sizeof(u8);
 	
-#if defined(ENABLE_NEON_A64)
+#if defined(ENABLE_AVX2)
+	// x86 can only look up 16 bytes at a time, so the 64 byte palette table is searched as
+	// four separate lookups that are masked together. This is still much cheaper than doing
+	// the color conversion one texel at a time.
+	__NDSTextureUnpackA3I5_AVX2<TEXCACHEFORMAT>(texelCount, srcData, srcPal, dstBuffer);
+#elif defined(ENABLE_SSSE3)
+	__NDSTextureUnpackA3I5_SSSE3<TEXCACHEFORMAT>(texelCount, srcData, srcPal, dstBuffer);
+#elif defined(ENABLE_NEON_A64)
 	// Only ARM NEON-A64 can perform register-based table lookups across 64 bytes, which just
 	// so happens to be the size of the palette table we need to search. As of this writing,
 	// no other SIMD instruction sets we're currently using have this capability.
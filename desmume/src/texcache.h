@@ -63,6 +63,7 @@ protected:
 	size_t _actualCacheSize;
 	size_t _cacheSizeThreshold;
 	u8 _paletteDump[PALETTE_DUMP_SIZE];
+	u8 *_paletteDumpSlot[6];			// Palette slot mapping at the time of the last palette dump
 	
 public:
 	TextureCache();
@@ -111,6 +112,12 @@ protected:
 	
 	size_t _packTotalSize;
 	
+	// VRAM slot mapping at the time the packed data was last read, and which slots the texture uses
+	u8 *_vramTexSlot[4];
+	u8 *_vramTexPalSlot[6];
+	u8 _vramTexSlotMask;
+	u8 _vramTexPalSlotMask;
+	
 	bool _suspectedInvalid;
 	bool _assumedInvalid;
 	bool _isLoadNeeded;
@@ -121,6 +128,8 @@ protected:
 	size_t _cacheAge; // A value of 0 means the texture was just used. The higher this value, the older the texture.
 	size_t _cacheUsageCount;
 	
+	void _UpdateVRAMSource();
+	
 public:
 	TextureStore();
 	TextureStore(const TEXIMAGE_PARAM texAttributes, const u32 palAttributes);
@@ -155,6 +164,8 @@ public:
 	
 	virtual void Load(void *targetBuffer);
 	
+	bool IsVRAMSourceChanged() const;
+	
 	bool IsSuspectedInvalid() const;
 	void SetSuspectedInvalid();
 	
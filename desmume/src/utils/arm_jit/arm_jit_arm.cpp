@@ -116,6 +116,7 @@ void jit_write() {
 #define CACHED_PTR(exp) PTR_STORE_REG
 
 u32 saveBlockSizeJIT = 0;
+JIT_link_struct JIT_LINK[2];
 
 static volatile unsigned int label_gen_num=0;
 unsigned int genlabel() {
@@ -372,6 +373,9 @@ static void init_jit_mem()
 	for(int proc=0; proc<2; proc++)
 		for(int i=0; i<0x4000; i++)
 			JIT.JIT_MEM[proc][i] = JIT_MEM[proc][i>>9] + (((i<<14) & JIT_MASK[proc][i>>9]) >> 1);
+
+	//the shared WRAM pages of the software TLB point into these
+	MMU_TLBRebuild();
 }
 
 #else
@@ -2190,6 +2194,12 @@ static u32 FASTCALL OP_LDM_STM(u32 adr, u32 regslo, u32 regshi, int n)
 	{
 		ptr = MMU.MAIN_MEM + (adr & _MMU_MAIN_MEM_MASK32);
 		cycles = n * ((PROCNUM==ARMCPU_ARM9) ? 4 : 2);
+		if(store)
+		{
+			// the span can't cross a 16KB boundary (see above), so its ends cover every page it touches
+			MMU_MainMemMarkDirty(adr & _MMU_MAIN_MEM_MASK32);
+			MMU_MainMemMarkDirty((adr + (n-1)*4*dir) & _MMU_MAIN_MEM_MASK32);
+		}
 	}
 	else if(PROCNUM==ARMCPU_ARM7 && !store && (adr & 0xFF800000) == 0x03800000)
 	{
@@ -4219,6 +4229,35 @@ void arm_jit_reset(bool enable, bool suppress_msg)
 #endif
 }
 
+void arm_jit_sync_timing()
+{
+	// the blocks compiled here always leave the memory timing to the helpers
+}
+
+#ifdef MAPPED_JIT_FUNCS
+void arm_jit_invalidate(const void *ptr, u32 len)
+{
+	const u8 *p = (const u8 *)ptr;
+	#define JITINVALIDATE(bank, mem) \
+		if (p >= mem && p < mem + ARRAY_SIZE(JIT.bank) * 2) \
+		{ \
+			const u32 ofs = (u32)(p - mem); \
+			memset(&JIT.bank[ofs >> 1], 0, (std::min<u32>(len, ARRAY_SIZE(JIT.bank) * 2 - ofs) >> 1) * sizeof(uintptr_t)); \
+		}
+		JITINVALIDATE(MAIN_MEM, MMU.MAIN_MEM);
+		JITINVALIDATE(SWIRAM, MMU.SWIRAM);
+		JITINVALIDATE(ARM9_ITCM, MMU.ARM9_ITCM);
+		JITINVALIDATE(ARM9_LCDC, MMU.ARM9_LCD);
+		JITINVALIDATE(ARM7_ERAM, MMU.ARM7_ERAM);
+		JITINVALIDATE(ARM7_WIRAM, MMU.ARM7_WIRAM);
+	#undef JITINVALIDATE
+
+	// the ARM7's view of VRAM is compiled per mapped address, which depends on the bank setup
+	if (p >= MMU.ARM9_LCD && p < MMU.ARM9_LCD + sizeof(MMU.ARM9_LCD))
+		memset(JIT.ARM7_WRAM, 0, sizeof(JIT.ARM7_WRAM));
+}
+#endif
+
 #if (PROFILER_JIT_LEVEL > 0)
 static int pcmp(PROFILER_COUNTER_INFO *info1, PROFILER_COUNTER_INFO *info2)
 {
@@ -6,6 +6,7 @@
 #include "common.h"
 #include "disc_io.h"
 #include "fatfile.h"
+#include "file_allocation_table.h"
 
 
 struct Instance
@@ -13,6 +14,8 @@ struct Instance
 	void* buffer;
 	int size_bytes;
 	devoptab_t* devops;
+	LIBFAT::SectorIO io;
+	void* ioParam;
 };
 
 Instance sInstance;
@@ -33,6 +36,8 @@ bool MEDIUM_io(bool write, sec_t sector, sec_t numSectors, void* buffer)
 	int have = gInstance->size_bytes - loc;
 	if(todo>have) 
 		return false;
+	if(gInstance->io)
+		return gInstance->io(gInstance->ioParam, write, (unsigned int)sector, (unsigned int)numSectors, buffer);
 	if(write)
 		memcpy((u8*)gInstance->buffer + loc,buffer,todo);
 	else
@@ -80,6 +85,8 @@ namespace LIBFAT
 		gInstance = &sInstance;
 		gInstance->buffer = buffer;
 		gInstance->size_bytes = size_bytes;
+		gInstance->io = NULL;
+		gInstance->ioParam = NULL;
 		fatMountSimple("fat",&discio);
 		gInstance->devops = GetDeviceOpTab(NULL);
 		
@@ -87,6 +94,17 @@ namespace LIBFAT
 		int zzz=9;
 	}
 
+	void Init(SectorIO io, void *param, int size_bytes)
+	{
+		gInstance = &sInstance;
+		gInstance->buffer = NULL;
+		gInstance->size_bytes = size_bytes;
+		gInstance->io = io;
+		gInstance->ioParam = param;
+		fatMountSimple("fat",&discio);
+		gInstance->devops = GetDeviceOpTab(NULL);
+	}
+
 	bool MkDir(const char *path)
 	{
 		_reent r;
@@ -108,6 +126,45 @@ namespace LIBFAT
 		return false;
 	}
 
+	bool ReserveFile(const char *path, int len, std::vector<SectorRun> &runs)
+	{
+		static const char zeroes[64*1024] = {0};
+
+		_reent r;
+		FILE_STRUCT file;
+		intptr_t fd = gInstance->devops->open_r(&r,&file,path,O_CREAT | O_RDWR,0);
+		if(fd == -1)
+			return false;
+
+		int done = 0;
+		while(done < len)
+		{
+			int todo = len - done;
+			if(todo > (int)sizeof(zeroes)) todo = (int)sizeof(zeroes);
+			if(gInstance->devops->write_r(&r, fd, zeroes, todo) != todo)
+				break;
+			done += todo;
+		}
+		gInstance->devops->close_r(&r, fd);
+		if(done != len)
+			return false;
+
+		runs.clear();
+		PARTITION* partition = file.partition;
+		for(uint32_t cluster = file.startCluster; _FAT_fat_isValidCluster(partition, cluster); cluster = _FAT_fat_nextCluster(partition, cluster))
+		{
+			const unsigned int sector = (unsigned int)_FAT_fat_clusterToSector(partition, cluster);
+			if(!runs.empty() && runs.back().sector + runs.back().count == sector)
+				runs.back().count += partition->sectorsPerCluster;
+			else
+			{
+				SectorRun run = { sector, partition->sectorsPerCluster };
+				runs.push_back(run);
+			}
+		}
+		return true;
+	}
+
 	void Shutdown()
 	{
 		fatUnmountDirect(gInstance->devops);
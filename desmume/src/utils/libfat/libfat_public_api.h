@@ -1,12 +1,26 @@
 #ifndef _LIBFAT_PUBLIC_API_H_
 #define _LIBFAT_PUBLIC_API_H_
 
+#include <vector>
+
 namespace LIBFAT
 {
+	//reads or writes whole 512 byte sectors, for images that aren't kept in one flat buffer
+	typedef bool (*SectorIO)(void *param, bool write, unsigned int sector, unsigned int count, void *buffer);
+
+	struct SectorRun
+	{
+		unsigned int sector, count;
+	};
+
 	void Init(void* buffer, int size_bytes);
+	void Init(SectorIO io, void *param, int size_bytes);
 	void Shutdown();
 	bool MkDir(const char *path);
 	bool WriteFile(const char *path, const void* data, int len);
+
+	//creates a zero-filled file and returns the sectors its clusters were given, as runs of consecutive sectors
+	bool ReserveFile(const char *path, int len, std::vector<SectorRun> &runs);
 };
 
 #endif //_LIBFAT_PUBLIC_API_H_
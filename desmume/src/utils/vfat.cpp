@@ -22,7 +22,11 @@
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <stack>
+#include <map>
+#include <vector>
+#include <unordered_map>
 
 #include "../types.h"
 #include "../debug.h"
@@ -35,6 +39,321 @@
 #include "vfat.h"
 #include "libfat/libfat_public_api.h"
 
+//an image where only the FAT metadata lives in memory. file contents are left on the host and fetched
+//a block at a time on first read; anything the guest writes is kept in a sector journal on top of that.
+//we never write back into the host files: the guest is free to move clusters around, so a sector that
+//started out as part of one host file may later belong to something else entirely.
+class EMUFILE_VFAT : public EMUFILE
+{
+public:
+	EMUFILE_VFAT(u32 sectors)
+		: building(true)
+		, numSectors(sectors)
+		, pos(0)
+		, numSlots(0)
+		, lastSector(0xFFFFFFFF)
+		, lastData(NULL)
+		, hostFp(NULL)
+		, hostFpIndex(0xFFFFFFFF)
+	{
+		for(int i=0;i<kCacheEntries;i++)
+		{
+			cache[i].file = 0xFFFFFFFF;
+			cache[i].data = NULL;
+		}
+	}
+
+	virtual ~EMUFILE_VFAT()
+	{
+		if(hostFp) ::fclose(hostFp);
+		for(int i=0;i<kCacheEntries;i++)
+			delete[] cache[i].data;
+		for(size_t i=0;i<slabs.size();i++)
+			delete[] slabs[i];
+	}
+
+	//called when libfat is done laying out the disk. until then, writes of all-zero sectors are dropped,
+	//since formatting and reserving the host files would otherwise touch every sector of the image
+	void finishBuild() { building = false; }
+
+	//file contents for the given sector runs come from the host file at path, up to len bytes
+	void addHostFile(const std::string& path, u32 len, const std::vector<LIBFAT::SectorRun>& runs)
+	{
+		const u32 index = (u32)hostFiles.size();
+		hostFiles.push_back(path);
+
+		u32 fileOfs = 0;
+		for(size_t i=0;i<runs.size() && fileOfs<len;i++)
+		{
+			HostExtent &extent = extents[runs[i].sector];
+			extent.count = runs[i].count;
+			extent.file = index;
+			extent.fileOfs = fileOfs;
+			fileOfs += runs[i].count*512;
+		}
+		lastSector = 0xFFFFFFFF;
+	}
+
+	static bool io(void *param, bool write, unsigned int sector, unsigned int count, void *buffer)
+	{
+		EMUFILE_VFAT* self = (EMUFILE_VFAT*)param;
+		u8* ptr = (u8*)buffer;
+		for(u32 i=0;i<count;i++,ptr+=512)
+		{
+			if(sector+i >= self->numSectors) return false;
+			if(write) self->writeSector(sector+i,ptr,0,512);
+			else memcpy(ptr,self->readSector(sector+i),512);
+		}
+		return true;
+	}
+
+	virtual EMUFILE* memwrap() { return this; }
+	virtual FILE *get_fp() { return NULL; }
+
+	virtual int fprintf(const char *format, ...)
+	{
+		va_list argptr;
+		va_start(argptr, format);
+		int amt = vsnprintf(0,0,format,argptr);
+		va_end(argptr);
+
+		char* tempbuf = new char[amt+1];
+		va_start(argptr, format);
+		vsprintf(tempbuf,format,argptr);
+		va_end(argptr);
+
+		fwrite(tempbuf,amt);
+		delete[] tempbuf;
+		return amt;
+	}
+
+	virtual int fgetc()
+	{
+		u8 temp = 0;
+		if(_fread(&temp,1) != 1)
+			return -1;
+		return temp;
+	}
+
+	virtual int fputc(int c)
+	{
+		u8 temp = (u8)c;
+		fwrite(&temp,1);
+		return 0;
+	}
+
+	virtual char* fgets(char* str, int num)
+	{
+		throw "Not tested: emufile vfat fgets";
+	}
+
+	virtual size_t _fread(const void *ptr, size_t bytes)
+	{
+		u8* dst = (u8*)ptr;
+		const u32 len = numSectors*512;
+		if(pos >= len)
+		{
+			_failbit = true;
+			return 0;
+		}
+		if(bytes > len-pos)
+		{
+			bytes = len-pos;
+			_failbit = true;
+		}
+
+		size_t done = 0;
+		while(done < bytes)
+		{
+			const u32 ofs = pos & 511;
+			u32 todo = 512 - ofs;
+			if(todo > bytes-done) todo = (u32)(bytes-done);
+			memcpy(dst+done,readSector(pos>>9)+ofs,todo);
+			done += todo;
+			pos += todo;
+		}
+		return done;
+	}
+
+	virtual size_t fwrite(const void *ptr, size_t bytes)
+	{
+		const u8* src = (const u8*)ptr;
+		const u32 len = numSectors*512;
+		if(pos >= len)
+		{
+			_failbit = true;
+			return 0;
+		}
+		if(bytes > len-pos)
+		{
+			bytes = len-pos;
+			_failbit = true;
+		}
+
+		size_t done = 0;
+		while(done < bytes)
+		{
+			const u32 ofs = pos & 511;
+			u32 todo = 512 - ofs;
+			if(todo > bytes-done) todo = (u32)(bytes-done);
+			writeSector(pos>>9,src+done,ofs,todo);
+			done += todo;
+			pos += todo;
+		}
+		return done;
+	}
+
+	virtual int fseek(int offset, int origin)
+	{
+		switch(origin) {
+			case SEEK_SET: pos = offset; break;
+			case SEEK_CUR: pos += offset; break;
+			case SEEK_END: pos = size()+offset; break;
+			default: assert(false);
+		}
+		return 0;
+	}
+
+	virtual int ftell() { return (int)pos; }
+	virtual int size() { return (int)(numSectors*512); }
+	virtual void fflush() {}
+
+	virtual void truncate(s32 length)
+	{
+		numSectors = ((u32)length+511)>>9;
+		for(std::unordered_map<u32,u32>::iterator it = journal.begin(); it != journal.end(); )
+		{
+			if(it->first >= numSectors) it = journal.erase(it);
+			else ++it;
+		}
+		if(length == 0)
+		{
+			journal.clear();
+			extents.clear();
+		}
+		if(pos > (u32)length) pos = length;
+		lastSector = 0xFFFFFFFF;
+	}
+
+private:
+	struct HostExtent
+	{
+		u32 count, file, fileOfs;
+	};
+
+	struct CacheEntry
+	{
+		u32 file, block;
+		u8* data;
+	};
+
+	static const int kBlockShift = 16;
+	static const int kCacheEntries = 128; //8MB of host data at most
+	static const int kSlabSectors = 256;
+
+	bool building;
+	u32 numSectors;
+	u32 pos;
+
+	//sectors the guest (or the build) has written, by sector number; values index into the slabs
+	std::unordered_map<u32,u32> journal;
+	std::vector<u8*> slabs;
+	u32 numSlots;
+
+	//host file contents by first sector of each run
+	std::map<u32,HostExtent> extents;
+	std::vector<std::string> hostFiles;
+	CacheEntry cache[kCacheEntries];
+
+	//the mpcf reads two bytes at a time, so remember where the last sector came from
+	u32 lastSector;
+	const u8* lastData;
+
+	FILE* hostFp;
+	u32 hostFpIndex;
+
+	u8* slot(u32 index) { return slabs[index/kSlabSectors] + (index%kSlabSectors)*512; }
+
+	const u8* readHost(u32 file, u32 fileOfs)
+	{
+		const u32 block = fileOfs >> kBlockShift;
+		CacheEntry &entry = cache[(file*31 + block) & (kCacheEntries-1)];
+		if(entry.file != file || entry.block != block)
+		{
+			if(!entry.data) entry.data = new u8[1<<kBlockShift];
+			size_t got = 0;
+			if(hostFpIndex != file)
+			{
+				if(hostFp) ::fclose(hostFp);
+				hostFp = ::fopen(hostFiles[file].c_str(),"rb");
+				hostFpIndex = file;
+			}
+			if(hostFp && !::fseek(hostFp,block<<kBlockShift,SEEK_SET))
+				got = ::fread(entry.data,1,1<<kBlockShift,hostFp);
+			else
+				printf("ERROR reading %s for fat\n",hostFiles[file].c_str());
+			memset(entry.data+got,0,(1<<kBlockShift)-got);
+			entry.file = file;
+			entry.block = block;
+			lastSector = 0xFFFFFFFF;
+		}
+		return entry.data + (fileOfs & ((1<<kBlockShift)-1));
+	}
+
+	const u8* readSector(u32 sector)
+	{
+		static const u8 zeroes[512] = {0};
+
+		if(sector == lastSector)
+			return lastData;
+
+		const u8* ret = zeroes;
+		std::unordered_map<u32,u32>::iterator it = journal.find(sector);
+		if(it != journal.end())
+			ret = slot(it->second);
+		else
+		{
+			std::map<u32,HostExtent>::iterator ext = extents.upper_bound(sector);
+			if(ext != extents.begin())
+			{
+				--ext;
+				if(sector - ext->first < ext->second.count)
+					ret = readHost(ext->second.file, ext->second.fileOfs + (sector - ext->first)*512);
+			}
+		}
+
+		lastSector = sector;
+		lastData = ret;
+		return ret;
+	}
+
+	void writeSector(u32 sector, const u8* src, u32 ofs, u32 len)
+	{
+		std::unordered_map<u32,u32>::iterator it = journal.find(sector);
+		u8* dst;
+		if(it != journal.end())
+			dst = slot(it->second);
+		else
+		{
+			if(building && ofs == 0 && len == 512)
+			{
+				bool zero = true;
+				for(int i=0;i<512 && zero;i++) zero = (src[i] == 0);
+				if(zero) return;
+			}
+
+			if(numSlots == slabs.size()*kSlabSectors)
+				slabs.push_back(new u8[kSlabSectors*512]);
+			dst = slot(numSlots);
+			memcpy(dst,readSector(sector),512);
+			journal[sector] = numSlots++;
+		}
+		memcpy(dst+ofs,src,len);
+		lastSector = sector;
+		lastData = dst;
+	}
+};
+
 
 enum EListCallbackArg {
 	EListCallbackArg_Item, EListCallbackArg_Pop
@@ -87,6 +406,9 @@ enum eCallbackType
 
 static eCallbackType callbackType;
 
+//for eCallbackType_Build, when file contents are left on the host:
+static EMUFILE_VFAT* lazyImage = NULL;
+
 //for eCallbackType_Count:
 static bool count_failed = false;
 static u64 dataSectors = 0;
@@ -139,7 +461,18 @@ static void DirectoryListCallback(RDIR* rdir, EListCallbackArg arg)
 	{
 		std::string path = currPath + path_default_slash() + fname;
 
-		if(callbackType == eCallbackType_Build)
+		if(callbackType == eCallbackType_Build && lazyImage)
+		{
+			int32_t len = path_get_size(path.c_str());
+			std::vector<LIBFAT::SectorRun> runs;
+			std::string virtPath = currVirtPath + "/" + fname;
+			printf("FAT + (%10.2f KB) %s \n",len/1024.f,virtPath.c_str());
+			if(len < 0 || !LIBFAT::ReserveFile(virtPath.c_str(),len,runs))
+				printf("ERROR adding file to fat\n");
+			else
+				lazyImage->addHostFile(path,len,runs);
+		}
+		else if(callbackType == eCallbackType_Build)
 		{
 			FILE* inf = fopen(path.c_str(),"rb");
 			if(inf)
@@ -170,7 +503,7 @@ static void DirectoryListCallback(RDIR* rdir, EListCallbackArg arg)
 		
 }
 
-bool VFAT::build(const char* path, int extra_MB)
+bool VFAT::build(const char* path, int extra_MB, bool lazy)
 {
 	dataSectors = 0;
 	currVirtPath = "";
@@ -204,6 +537,30 @@ bool VFAT::build(const char* path, int extra_MB)
 	}
 	
 	delete file;
+	file = NULL;
+
+	if(lazy)
+	{
+		lazyImage = new EMUFILE_VFAT((u32)dataSectors);
+		file = lazyImage;
+
+		{
+			EmuFat fat(file);
+			EmuFatVolume vol;
+			vol.init(&fat);
+			vol.formatNew((u32)dataSectors);
+		}
+
+		LIBFAT::Init(EMUFILE_VFAT::io,lazyImage,(int)(dataSectors*512));
+		callbackType = eCallbackType_Build;
+		list_files(path, DirectoryListCallback);
+		LIBFAT::Shutdown();
+
+		lazyImage->finishBuild();
+		lazyImage = NULL;
+		return true;
+	}
+
 	try 
 	{
 		file = new EMUFILE_MEMORY(dataSectors*512);
@@ -25,7 +25,8 @@ class VFAT
 public:
 	VFAT();
 	~VFAT();
-	bool build(const char* path, int extra_MB=0);
+	//with lazy set, file contents stay on the host and are only read when the guest asks for them
+	bool build(const char* path, int extra_MB=0, bool lazy=false);
 
 	EMUFILE* detach();
 